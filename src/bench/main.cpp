@@ -0,0 +1,830 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <app_com.h>
+#include <bindless_table.h>
+#include <culling.h>
+#include <descriptor_allocator.h>
+#include <dynamic_rendering.h>
+#include <engine_vk.h>
+#include <job_system.h>
+#include <json_helper.h>
+#include <offscreen_target.h>
+#include <parallel_recorder.h>
+#include <render_graph.h>
+#include <staging_uploader.h>
+#include <swapchain.h>
+#include <transient_allocator.h>
+#include <triangle_renderer.h>
+
+constexpr int WIDTH = 1920;
+constexpr int HEIGTH = 1080;
+
+constexpr auto RESULTS_FILE = "bench_results.json";
+
+constexpr std::size_t BENCH_WARMUP = 20;
+constexpr std::size_t BENCH_FRAMES = 500;
+constexpr std::array<std::size_t, 3> BENCH_DRAWS { 1, 1000, 100000 };
+
+constexpr std::size_t CULLING_INSTANCES = 100000;
+constexpr float CULLING_SPREAD = 2.0f;
+
+constexpr std::size_t CPU_CULLING_OBJECTS = 1000000;
+constexpr std::size_t CPU_CULLING_ITERATIONS = 50;
+
+constexpr std::size_t RECORDING_DRAWS = 10000;
+constexpr std::size_t RECORDING_WARMUP = 5;
+constexpr std::size_t RECORDING_ITERATIONS = 50;
+
+constexpr vk::DeviceSize UPLOAD_BUFFER_SIZE = 4 * 1024 * 1024;
+constexpr std::size_t UPLOAD_BUFFERS = 16;
+constexpr std::size_t UPLOAD_ITERATIONS = 10;
+
+constexpr vk::DeviceSize STREAM_CHUNK_SIZE = 4 * 1024 * 1024;
+constexpr std::size_t STREAM_BUFFERS = 4;
+constexpr std::size_t STREAM_DRAWS = 1000;
+
+constexpr std::size_t PIPELINE_ITERATIONS = 20;
+constexpr std::size_t RECREATE_ITERATIONS = 20;
+
+constexpr vk::DeviceSize TRANSIENT_CONSTANTS_SIZE = 256;
+constexpr std::size_t TRANSIENT_CONSTANTS = 4096;
+
+constexpr std::uint32_t DESCRIPTOR_SETS = 64;
+constexpr std::size_t DESCRIPTOR_UPDATES = 100000;
+
+struct bench_result {
+	std::string scenario;
+	std::string parameter;
+	std::size_t parameterValue;
+	double value;
+	std::string unit;
+};
+
+using bench_clock = std::chrono::steady_clock;
+
+double elapsedMs(bench_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+double median(std::vector<double> samples) {
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+const std::vector<triangle_pipeline::triangle_vertex>& triangleVertices() {
+	static const std::vector<triangle_pipeline::triangle_vertex> vertices = {
+		triangle_pipeline::triangle_vertex(glm::vec3{0.0f, -0.5f, 0.0f}),
+		triangle_pipeline::triangle_vertex(glm::vec3{0.5f, 0.5f, 0.0f}),
+		triangle_pipeline::triangle_vertex(glm::vec3{-0.5f, 0.5f, 0.0f}),
+	};
+
+	return vertices;
+}
+
+// Average CPU time per frame of the full renderer loop, GPU bound frames show up through the fence waits
+double trianglesBenchmark(const engine_vk& engine, std::size_t draws, bool dynamicRendering = false) {
+	triangle_renderer renderer(engine, std::make_unique<offscreen_target>(engine, vk::Extent2D{ WIDTH, HEIGTH }), nullptr, draws);
+	static_cast<void>(renderer.setDynamicRendering(dynamicRendering));
+
+	for (std::size_t i = 0; i < BENCH_WARMUP; ++i) {
+		renderer.drawFrame();
+	}
+
+	const auto start = bench_clock::now();
+
+	for (std::size_t i = 0; i < BENCH_FRAMES; ++i) {
+		renderer.drawFrame();
+	}
+
+	engine.waitDeviceIdle();
+
+	return elapsedMs(start) / static_cast<double>(BENCH_FRAMES);
+}
+
+// Same scene as trianglesBenchmark but every instance is drawn by a single indirect command
+double indirectBenchmark(const engine_vk& engine, const std::vector<glm::mat4>& transforms, bool cull) {
+	triangle_renderer renderer(engine, std::make_unique<offscreen_target>(engine, vk::Extent2D{ WIDTH, HEIGTH }));
+
+	static_cast<void>(renderer.setInstances(transforms, cull));
+
+	for (std::size_t i = 0; i < BENCH_WARMUP; ++i) {
+		renderer.drawFrame();
+	}
+
+	const auto start = bench_clock::now();
+
+	for (std::size_t i = 0; i < BENCH_FRAMES; ++i) {
+		renderer.drawFrame();
+	}
+
+	engine.waitDeviceIdle();
+
+	return elapsedMs(start) / static_cast<double>(BENCH_FRAMES);
+}
+
+// Culls on the CPU every frame with the SIMD kernel and hands the visible list to the renderer
+double cpuCulledBenchmark(const engine_vk& engine, const std::vector<glm::mat4>& transforms) {
+	triangle_renderer renderer(engine, std::make_unique<offscreen_target>(engine, vk::Extent2D{ WIDTH, HEIGTH }));
+
+	static_cast<void>(renderer.setInstances(transforms));
+
+	culling::sphere_set spheres;
+	spheres.reserve(transforms.size());
+
+	for (const auto& transform : transforms) {
+		spheres.add(glm::vec3(transform[3]), triangle_renderer::bounding_radius * glm::length(glm::vec3(transform[0])));
+	}
+
+	const auto frustum = culling::frustum::fromViewProjection(glm::mat4(1.0f));
+	std::vector<std::uint32_t> visible;
+
+	const auto frame = [&]() {
+		culling::cull(frustum, spheres, visible);
+		static_cast<void>(renderer.setVisibleInstances(visible));
+		renderer.drawFrame();
+	};
+
+	for (std::size_t i = 0; i < BENCH_WARMUP; ++i) {
+		frame();
+	}
+
+	const auto start = bench_clock::now();
+
+	for (std::size_t i = 0; i < BENCH_FRAMES; ++i) {
+		frame();
+	}
+
+	engine.waitDeviceIdle();
+
+	return elapsedMs(start) / static_cast<double>(BENCH_FRAMES);
+}
+
+// Small triangles on a square grid reaching CULLING_SPREAD in every direction, so most of them lie outside the clip volume
+std::vector<glm::mat4> spreadInstances(std::size_t count) {
+	const auto side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+	const auto step = 2.0f * CULLING_SPREAD / static_cast<float>(side);
+
+	std::vector<glm::mat4> transforms;
+	transforms.reserve(count);
+
+	for (std::size_t i = 0; i < count; ++i) {
+		auto transform = glm::mat4(0.5f * step);
+		transform[3] = glm::vec4(-CULLING_SPREAD + step * static_cast<float>(i % side), -CULLING_SPREAD + step * static_cast<float>(i / side), 0.0f, 1.0f);
+		transforms.emplace_back(transform);
+	}
+
+	return transforms;
+}
+
+// Objects scattered around a unit frustum so that roughly a third of them survive
+culling::sphere_set randomSpheres(std::size_t count) {
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-1.5f, 1.5f);
+	std::uniform_real_distribution<float> radius(0.001f, 0.05f);
+
+	culling::sphere_set spheres;
+	spheres.reserve(count);
+
+	for (std::size_t i = 0; i < count; ++i) {
+		spheres.add(glm::vec3(position(random), position(random), position(random)), radius(random));
+	}
+
+	return spheres;
+}
+
+// Median milliseconds to cull CPU_CULLING_OBJECTS spheres, naive is one glm test per object over an array of structures
+std::pair<double, double> cpuCullingBenchmark() {
+	const auto spheres = randomSpheres(CPU_CULLING_OBJECTS);
+	const auto frustum = culling::frustum::fromViewProjection(glm::mat4(1.0f));
+
+	std::vector<glm::vec4> objects;
+	objects.reserve(spheres.size());
+
+	for (std::size_t i = 0; i < spheres.size(); ++i) {
+		objects.emplace_back(spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i]);
+	}
+
+	std::vector<std::uint32_t> visible;
+	visible.reserve(spheres.size());
+
+	std::vector<double> naive;
+	std::vector<double> simd;
+
+	for (std::size_t i = 0; i < CPU_CULLING_ITERATIONS; ++i) {
+		auto start = bench_clock::now();
+
+		visible.clear();
+
+		for (std::size_t j = 0; j < objects.size(); ++j) {
+			if (culling::isVisible(frustum, glm::vec3(objects[j]), objects[j].w)) {
+				visible.emplace_back(static_cast<std::uint32_t>(j));
+			}
+		}
+
+		naive.emplace_back(elapsedMs(start));
+
+		start = bench_clock::now();
+		culling::cull(frustum, spheres, visible);
+		simd.emplace_back(elapsedMs(start));
+	}
+
+	return { median(naive), median(simd) };
+}
+
+// The SIMD kernels must pick exactly the objects the per-object tests pick, timing them alone wouldn't notice a wrong mask
+bool cullingMatchesReference() {
+	const auto spheres = randomSpheres(CPU_CULLING_OBJECTS);
+	const auto frustum = culling::frustum::fromViewProjection(glm::mat4(1.0f));
+
+	culling::box_set boxes;
+	boxes.reserve(spheres.size());
+
+	for (std::size_t i = 0; i < spheres.size(); ++i) {
+		boxes.add(glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]), glm::vec3(spheres.radius[i]));
+	}
+
+	std::vector<std::uint32_t> visible;
+	std::vector<std::uint32_t> reference;
+
+	culling::cull(frustum, spheres, visible);
+
+	for (std::size_t i = 0; i < spheres.size(); ++i) {
+		if (culling::isVisible(frustum, glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i])) {
+			reference.emplace_back(static_cast<std::uint32_t>(i));
+		}
+	}
+
+	if (visible != reference) {
+		return false;
+	}
+
+	reference.clear();
+	culling::cull(frustum, boxes, visible);
+
+	for (std::size_t i = 0; i < boxes.size(); ++i) {
+		if (culling::isVisible(frustum, glm::vec3(boxes.x[i], boxes.y[i], boxes.z[i]), glm::vec3(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]))) {
+			reference.emplace_back(static_cast<std::uint32_t>(i));
+		}
+	}
+
+	return visible == reference;
+}
+
+double recordingBenchmark(const engine_vk& engine, job_system& jobs) {
+	triangle_pipeline trianglePipeline(engine);
+	offscreen_target target(engine, vk::Extent2D{ WIDTH, HEIGTH });
+	renderpass renderPass(engine, target);
+
+	trianglePipeline.finalize(renderPass, target);
+
+	const auto& vertices = triangleVertices();
+	const auto vertexUpload = engine.createLocalBufferWithData(std::span(vertices).size_bytes(), vk::BufferUsageFlagBits::eVertexBuffer, vertices.data());
+	const auto& vertexBuffer = vertexUpload.first;
+	vertexUpload.second.wait();
+
+	parallel_recorder recorder(engine, jobs, 1);
+	const auto primary = std::move(engine.allocateCmdBuffers(vk::QueueFlagBits::eGraphics, vk::CommandBufferLevel::ePrimary, 1)[0]);
+
+	vk::CommandBufferInheritanceInfo cbii {};
+	renderPass.inherit(cbii, 0);
+
+	const auto extent = target.getExtent();
+	const vk::Viewport viewPort { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	const vk::Rect2D renderArea {{0, 0}, extent};
+	const std::vector<vk::ClearValue> clearValues{ vk::ClearColorValue(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f}) };
+
+	const auto recordDraws = [&](const vk::CommandBuffer& buffer, std::size_t begin, std::size_t end) {
+		buffer.setViewport(0, 1, &viewPort);
+		buffer.setScissor(0, 1, &renderArea);
+
+		trianglePipeline.bind(buffer, vk::PipelineBindPoint::eGraphics);
+
+		const vk::DeviceSize offset = 0;
+
+		for (std::size_t i = begin; i < end; ++i) {
+			buffer.bindVertexBuffers(0, 1, &vertexBuffer.buffer.get(), &offset);
+			buffer.draw(3, 1, 0, 0);
+		}
+	};
+
+	std::vector<double> timings;
+
+	for (std::size_t i = 0; i < RECORDING_WARMUP + RECORDING_ITERATIONS; ++i) {
+		recorder.beginFrame(0);
+		primary->reset({});
+
+		const auto start = bench_clock::now();
+
+		const auto secondaries = recorder.record(0, cbii, RECORDING_DRAWS, recordDraws);
+
+		primary->begin(vk::CommandBufferBeginInfo{});
+		renderPass.begin(primary, 0, renderArea, clearValues, vk::SubpassContents::eSecondaryCommandBuffers);
+		primary->executeCommands(static_cast<std::uint32_t>(secondaries.size()), secondaries.data());
+		primary->endRenderPass();
+		primary->end();
+
+		const auto elapsed = elapsedMs(start);
+
+		if (i >= RECORDING_WARMUP) {
+			timings.emplace_back(elapsed);
+		}
+	}
+
+	return median(timings);
+}
+
+// Depth prepass, G-buffer, lighting and post into an offscreen image, plus a debug pass the graph culls
+std::pair<double, render_graph::statistics> renderGraphBenchmark(const engine_vk& engine) {
+	offscreen_target target(engine, vk::Extent2D{ WIDTH, HEIGTH });
+	const auto extent = target.getExtent();
+
+	render_graph graph(engine);
+
+	graph.createAttachment("depth", { vk::Format::eD32Sfloat, extent, vk::ImageAspectFlagBits::eDepth });
+	graph.createAttachment("albedo", { vk::Format::eR8G8B8A8Unorm, extent });
+	graph.createAttachment("lit", { vk::Format::eR16G16B16A16Sfloat, extent });
+	graph.createAttachment("debug_view", { vk::Format::eR8G8B8A8Unorm, extent });
+	graph.importImage("output", { target.getFormat(), extent }, vk::ImageLayout::eUndefined, target.getFinalLayout());
+	graph.markOutput("output");
+
+	const vk::ClearColorValue black(std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f });
+
+	triangle_pipeline trianglePipeline(engine);
+
+	const auto& vertices = triangleVertices();
+	const auto vertexUpload = engine.createLocalBufferWithData(std::span(vertices).size_bytes(), vk::BufferUsageFlagBits::eVertexBuffer, vertices.data());
+	const auto& vertexBuffer = vertexUpload.first;
+	vertexUpload.second.wait();
+
+	graph.addGraphicsPass("prepass").writeDepth("depth", vk::ClearDepthStencilValue{ 1.0f, 0 });
+	graph.addGraphicsPass("gbuffer").readDepth("depth").writeColor("albedo", black).execute([&](const vk::CommandBuffer& buffer) {
+		const vk::Viewport viewPort { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+		const vk::Rect2D scissor {{0, 0}, extent};
+		const vk::DeviceSize offset = 0;
+
+		buffer.setViewport(0, 1, &viewPort);
+		buffer.setScissor(0, 1, &scissor);
+		trianglePipeline.bind(buffer, vk::PipelineBindPoint::eGraphics);
+		buffer.bindVertexBuffers(0, 1, &vertexBuffer.buffer.get(), &offset);
+		buffer.draw(3, 1, 0, 0);
+	});
+	graph.addGraphicsPass("lighting").sample("albedo").writeColor("lit", black);
+	graph.addGraphicsPass("post").sample("lit").writeColor("output", black);
+	graph.addGraphicsPass("debug").sample("albedo").writeColor("debug_view", black);
+
+	graph.compile();
+	trianglePipeline.finalize(graph.getRenderPass("gbuffer"), 0);
+
+	const auto buffer = std::move(engine.allocateCmdBuffers(vk::QueueFlagBits::eGraphics, vk::CommandBufferLevel::ePrimary, 1)[0]);
+
+	std::vector<double> timings;
+
+	for (std::size_t frame = 0; frame < BENCH_WARMUP + BENCH_FRAMES; ++frame) {
+		const auto image = frame % target.getNumImages();
+		graph.setImage("output", target.getImage(image), target.getImageView(image));
+
+		const auto start = bench_clock::now();
+
+		buffer->begin(vk::CommandBufferBeginInfo{});
+		graph.execute(buffer.get());
+		buffer->end();
+
+		engine.waitTimeline(vk::QueueFlagBits::eGraphics, engine.submit(vk::QueueFlagBits::eGraphics, { engine_vk::submission{ { buffer.get() } } }));
+
+		if (frame >= BENCH_WARMUP) {
+			timings.emplace_back(elapsedMs(start));
+		}
+	}
+
+	return { median(timings), graph.getStatistics() };
+}
+
+// G-buffer written and consumed within one render pass, the attachments stay in tile memory on tilers
+double subpassBenchmark(const engine_vk& engine) {
+	offscreen_target target(engine, vk::Extent2D{ WIDTH, HEIGTH });
+
+	const std::vector<renderpass::transient_attachment> gBuffer {
+		{ vk::Format::eR8G8B8A8Unorm },
+		{ vk::Format::eR16G16B16A16Sfloat },
+		{ vk::Format::eD32Sfloat, vk::ImageAspectFlagBits::eDepth, vk::ClearDepthStencilValue{ 1.0f, 0 } }
+	};
+
+	renderpass renderPass(engine, target, gBuffer, {
+		renderpass::subpass_info{ { 1, 2 }, {}, 3 },
+		renderpass::subpass_info{ { 0 }, { 1, 2 } }
+	});
+
+	const auto buffer = std::move(engine.allocateCmdBuffers(vk::QueueFlagBits::eGraphics, vk::CommandBufferLevel::ePrimary, 1)[0]);
+	const vk::Rect2D renderArea {{0, 0}, target.getExtent()};
+
+	std::vector<double> timings;
+
+	for (std::size_t frame = 0; frame < BENCH_WARMUP + BENCH_FRAMES; ++frame) {
+		const auto start = bench_clock::now();
+
+		buffer->begin(vk::CommandBufferBeginInfo{});
+		renderPass.begin(buffer, frame % target.getNumImages(), renderArea, {}, vk::SubpassContents::eInline);
+		buffer->nextSubpass(vk::SubpassContents::eInline);
+		buffer->endRenderPass();
+		buffer->end();
+
+		engine.waitTimeline(vk::QueueFlagBits::eGraphics, engine.submit(vk::QueueFlagBits::eGraphics, { engine_vk::submission{ { buffer.get() } } }));
+
+		if (frame >= BENCH_WARMUP) {
+			timings.emplace_back(elapsedMs(start));
+		}
+	}
+
+	return median(timings);
+}
+
+// Staging ring throughput from host memory to device local buffers, including buffer creation
+double uploadBenchmark(const engine_vk& engine) {
+	const std::vector<std::uint8_t> data(UPLOAD_BUFFER_SIZE, 0xAB);
+
+	std::vector<double> timings;
+
+	for (std::size_t i = 0; i < UPLOAD_ITERATIONS; ++i) {
+		std::vector<engine_vk::vk_buffer> buffers;
+		buffers.reserve(UPLOAD_BUFFERS);
+
+		const auto start = bench_clock::now();
+
+		for (std::size_t j = 0; j < UPLOAD_BUFFERS; ++j) {
+			buffers.emplace_back(engine.createLocalBufferWithData(UPLOAD_BUFFER_SIZE, vk::BufferUsageFlagBits::eVertexBuffer, data.data()).first);
+		}
+
+		engine.getUploader().flush().wait();
+
+		timings.emplace_back(elapsedMs(start));
+	}
+
+	const auto megabytes = static_cast<double>(UPLOAD_BUFFER_SIZE * UPLOAD_BUFFERS) / (1024.0 * 1024.0);
+
+	return megabytes / (median(timings) / 1000.0);
+}
+
+// One chunk uploaded per rendered frame, with a dedicated transfer queue the copies overlap the frames
+std::pair<double, double> streamingBenchmark(const engine_vk& engine) {
+	triangle_renderer renderer(engine, std::make_unique<offscreen_target>(engine, vk::Extent2D{ WIDTH, HEIGTH }), nullptr, STREAM_DRAWS);
+
+	std::vector<engine_vk::vk_buffer> buffers;
+
+	for (std::size_t i = 0; i < STREAM_BUFFERS; ++i) {
+		buffers.emplace_back(engine.createBuffer(STREAM_CHUNK_SIZE, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst, engine_vk::memory_usage::device_local));
+	}
+
+	const std::vector<std::uint8_t> data(STREAM_CHUNK_SIZE, 0xEF);
+	auto& uploader = engine.getUploader();
+
+	for (std::size_t i = 0; i < BENCH_WARMUP; ++i) {
+		renderer.drawFrame();
+	}
+
+	const auto start = bench_clock::now();
+
+	for (std::size_t i = 0; i < BENCH_FRAMES; ++i) {
+		static_cast<void>(uploader.upload(buffers[i % buffers.size()], 0, data.data(), data.size()));
+		static_cast<void>(uploader.flush());
+
+		renderer.drawFrame();
+	}
+
+	engine.waitDeviceIdle();
+
+	const auto elapsed = elapsedMs(start);
+	const auto megabytes = static_cast<double>(STREAM_CHUNK_SIZE * BENCH_FRAMES) / (1024.0 * 1024.0);
+
+	return { megabytes / (elapsed / 1000.0), elapsed / static_cast<double>(BENCH_FRAMES) };
+}
+
+// Shader module loading plus pipeline creation, served from the pipeline cache after the first iteration
+std::pair<double, double> pipelineBenchmark(const engine_vk& engine) {
+	offscreen_target target(engine, vk::Extent2D{ WIDTH, HEIGTH });
+	renderpass renderPass(engine, target);
+
+	std::vector<double> timings;
+
+	for (std::size_t i = 0; i < PIPELINE_ITERATIONS; ++i) {
+		const auto start = bench_clock::now();
+
+		triangle_pipeline trianglePipeline(engine);
+		trianglePipeline.finalize(renderPass, target);
+
+		timings.emplace_back(elapsedMs(start));
+	}
+
+	return { timings.front(), median(timings) };
+}
+
+// Everything the renderer rebuilds when its target goes out of date, with dynamic rendering there are no framebuffers
+double recreateBenchmark(const engine_vk& engine, render_target& target, const std::function<void(std::size_t)>& prepare, bool dynamicRendering = false) {
+	renderpass renderPass(engine, target);
+	dynamic_rendering dynamicPass(engine, target);
+
+	std::vector<double> timings;
+
+	for (std::size_t i = 0; i < RECREATE_ITERATIONS; ++i) {
+		prepare(i);
+
+		const auto start = bench_clock::now();
+
+		target.recreate();
+
+		if (dynamicRendering) {
+			static_cast<void>(dynamicPass.updateFormat());
+		} else {
+			if (renderPass.updateFormat()) {
+				renderPass.createPass();
+			}
+
+			renderPass.createFrameBuffers();
+		}
+
+		// Nothing is in flight here, so the previous iteration's resources are freed right away
+		static_cast<void>(engine.collectRetired());
+
+		timings.emplace_back(elapsedMs(start));
+	}
+
+	return median(timings);
+}
+
+// Streaming per-draw constants through persistently mapped memory, as a frame loop would
+double transientBenchmark(const engine_vk& engine) {
+	transient_allocator constants(engine, render_target::FRAMES_IN_FLIGHT, TRANSIENT_CONSTANTS_SIZE * TRANSIENT_CONSTANTS * 2);
+
+	const std::vector<std::uint8_t> data(TRANSIENT_CONSTANTS_SIZE, 0xCD);
+
+	const auto start = bench_clock::now();
+
+	for (std::size_t frame = 0; frame < BENCH_FRAMES; ++frame) {
+		constants.beginFrame(frame % render_target::FRAMES_IN_FLIGHT);
+
+		for (std::size_t i = 0; i < TRANSIENT_CONSTANTS; ++i) {
+			const auto allocation = constants.allocate(TRANSIENT_CONSTANTS_SIZE);
+			std::memcpy(allocation->data, data.data(), data.size());
+		}
+
+		constants.flush();
+	}
+
+	const auto megabytes = static_cast<double>(TRANSIENT_CONSTANTS_SIZE * TRANSIENT_CONSTANTS * BENCH_FRAMES) / (1024.0 * 1024.0);
+
+	return megabytes / (elapsedMs(start) / 1000.0);
+}
+
+// Updates per second of a uniform buffer descriptor, cycling through a fixed set of descriptor sets
+double descriptorBenchmark(const engine_vk& engine) {
+	triangle_pipeline trianglePipeline(engine);
+
+	trianglePipeline.setDescriptorSetLayout({ vk::DescriptorSetLayoutBinding{ 0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex } });
+	trianglePipeline.createDescriptorSetPool({ vk::DescriptorPoolSize{ vk::DescriptorType::eUniformBuffer, DESCRIPTOR_SETS } }, DESCRIPTOR_SETS);
+
+	const auto sets = trianglePipeline.getSets(DESCRIPTOR_SETS);
+	const auto uniformBuffer = engine.createBuffer(256, vk::BufferUsageFlagBits::eUniformBuffer, engine_vk::memory_usage::upload);
+
+	const auto start = bench_clock::now();
+
+	for (std::size_t i = 0; i < DESCRIPTOR_UPDATES; ++i) {
+		const vk::DescriptorBufferInfo dbi { uniformBuffer.buffer.get(), 0, 256 };
+
+		const vk::WriteDescriptorSet wds {
+			sets[i % sets.size()],
+			0,
+			0,
+			1,
+			vk::DescriptorType::eUniformBuffer,
+			nullptr,
+			&dbi
+		};
+
+		engine.updateDescriptorSets(wds);
+	}
+
+	return static_cast<double>(DESCRIPTOR_UPDATES) / (elapsedMs(start) / 1000.0);
+}
+
+// Per-draw sets allocated from per-frame pools and written through an update template, pools are reset once per frame
+double descriptorAllocatorBenchmark(const engine_vk& engine) {
+	triangle_pipeline trianglePipeline(engine);
+	trianglePipeline.setDescriptorSetLayout({ vk::DescriptorSetLayoutBinding{ 0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex } });
+
+	const auto updateTemplate = trianglePipeline.createUpdateTemplate({
+		vk::DescriptorUpdateTemplateEntry{ 0, 0, 1, vk::DescriptorType::eUniformBuffer, 0, sizeof(vk::DescriptorBufferInfo) }
+	});
+
+	descriptor_allocator descriptors(engine, render_target::FRAMES_IN_FLIGHT);
+	const auto uniformBuffer = engine.createBuffer(256, vk::BufferUsageFlagBits::eUniformBuffer, engine_vk::memory_usage::upload);
+	const vk::DescriptorBufferInfo dbi { uniformBuffer.buffer.get(), 0, 256 };
+
+	const auto setsPerFrame = DESCRIPTOR_UPDATES / BENCH_FRAMES;
+
+	const auto start = bench_clock::now();
+
+	for (std::size_t frame = 0; frame < BENCH_FRAMES; ++frame) {
+		descriptors.beginFrame(frame % render_target::FRAMES_IN_FLIGHT);
+
+		for (std::size_t i = 0; i < setsPerFrame; ++i) {
+			engine.updateDescriptorSet(descriptors.allocate(trianglePipeline.getDescriptorLayout()), updateTemplate.get(), &dbi);
+		}
+	}
+
+	return static_cast<double>(setsPerFrame * BENCH_FRAMES) / (elapsedMs(start) / 1000.0);
+}
+
+// Buffers registered per second in the bindless table, each slot is released again right away like a streamed resource
+double bindlessBenchmark(const engine_vk& engine, bindless_table& table) {
+	const auto storageBuffer = engine.createBuffer(256, vk::BufferUsageFlagBits::eStorageBuffer, engine_vk::memory_usage::device_local);
+
+	const auto start = bench_clock::now();
+
+	for (std::size_t i = 0; i < DESCRIPTOR_UPDATES; ++i) {
+		table.remove(bindless_table::kind::buffer, table.addBuffer(storageBuffer.buffer.get()));
+	}
+
+	static_cast<void>(engine.collectRetired());
+
+	return static_cast<double>(DESCRIPTOR_UPDATES) / (elapsedMs(start) / 1000.0);
+}
+
+bool writeResults(const std::string& filename, const std::string& device, const std::vector<bench_result>& results) {
+	std::ofstream output(filename);
+
+	if (!output.good()) {
+		return false;
+	}
+
+	output << "{\n\t\"device\": \"" << com::jsonEscape(device) << "\",\n"
+		   << "\t\"width\": " << WIDTH << ",\n\t\"height\": " << HEIGTH << ",\n"
+		   << "\t\"frames\": " << BENCH_FRAMES << ",\n"
+		   << "\t\"results\": [";
+
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		const auto& r = results[i];
+
+		output << (i == 0 ? "" : ",") << "\n\t\t{ \"scenario\": \"" << com::jsonEscape(r.scenario) << "\", \""
+			   << com::jsonEscape(r.parameter) << "\": " << r.parameterValue << ", \"value\": " << r.value << ", \"unit\": \"" << com::jsonEscape(r.unit) << "\" }";
+	}
+
+	output << "\n\t]\n}\n";
+
+	return output.good();
+}
+
+// display_bench [results.json], everything but the swapchain scenario runs without a window
+int main(int argc, char* argv[]) {
+	auto logger_glfw = spdlog::stdout_color_mt("glfw");
+	auto logger_graphics = spdlog::stdout_color_mt("graphics");
+	auto logger_bench = spdlog::stdout_color_mt("bench");
+
+	const std::string resultsFile = argc > 1 ? argv[1] : RESULTS_FILE;
+
+	std::vector<bench_result> results;
+
+	const auto report = [&results, &logger_bench](bench_result result) {
+		logger_bench->info("{} ({} {}): {:.3f} {}", result.scenario, result.parameter, result.parameterValue, result.value, result.unit);
+		results.emplace_back(std::move(result));
+	};
+
+	std::string device;
+
+	{
+		engine_vk engine;
+		device = engine.getDeviceName();
+
+		for (const auto draws : BENCH_DRAWS) {
+			report({ "triangles", "draws", draws, trianglesBenchmark(engine, draws), "ms/frame" });
+		}
+
+		if (engine.getCapabilities().supportsDynamicRendering()) {
+			for (const auto draws : BENCH_DRAWS) {
+				report({ "triangles_dynamic_rendering", "draws", draws, trianglesBenchmark(engine, draws, true), "ms/frame" });
+			}
+		}
+
+		for (const auto instances : BENCH_DRAWS) {
+			report({ "triangles_indirect", "instances", instances, indirectBenchmark(engine, std::vector<glm::mat4>(instances, glm::mat4(1.0f)), false), "ms/frame" });
+		}
+
+		const auto spread = spreadInstances(CULLING_INSTANCES);
+		report({ "triangles_unculled", "instances", CULLING_INSTANCES, indirectBenchmark(engine, spread, false), "ms/frame" });
+
+		if (engine.getCapabilities().features.drawIndirectFirstInstance) {
+			report({ "triangles_gpu_culled", "instances", CULLING_INSTANCES, indirectBenchmark(engine, spread, true), "ms/frame" });
+		}
+
+		if (engine.getCapabilities().features.drawIndirectFirstInstance) {
+			report({ "triangles_cpu_culled", "instances", CULLING_INSTANCES, cpuCulledBenchmark(engine, spread), "ms/frame" });
+		}
+
+		if (!cullingMatchesReference()) {
+			logger_bench->error("SIMD culling ({} lanes) disagrees with the per-object tests!", culling::LANES);
+			return EXIT_FAILURE;
+		}
+
+		const auto [naiveCulling, simdCulling] = cpuCullingBenchmark();
+		report({ "cpu_culling_naive", "objects", CPU_CULLING_OBJECTS, naiveCulling, "ms" });
+		report({ "cpu_culling_simd", "lanes", culling::LANES, simdCulling, "ms" });
+		report({ "cpu_culling_speedup", "objects", CPU_CULLING_OBJECTS, naiveCulling / simdCulling, "x" });
+
+		double singleThreaded = 0.0;
+
+		for (std::size_t threads = 1; threads <= std::max(1u, std::thread::hardware_concurrency()); threads *= 2) {
+			job_system jobs(threads);
+
+			const auto median = recordingBenchmark(engine, jobs);
+
+			if (threads == 1) {
+				singleThreaded = median;
+			}
+
+			report({ "recording", "threads", threads, median, "ms" });
+			report({ "recording_speedup", "threads", threads, singleThreaded / median, "x" });
+		}
+
+		const auto [graphFrame, graphStats] = renderGraphBenchmark(engine);
+		report({ "render_graph_frame", "passes", graphStats.passes, graphFrame, "ms" });
+		report({ "render_graph_barriers", "passes", graphStats.passes, static_cast<double>(graphStats.barriers), "barriers" });
+		report({ "render_graph_transient_memory", "culled", graphStats.culledPasses, static_cast<double>(graphStats.transientBytes) / static_cast<double>(graphStats.unaliasedBytes), "x unaliased" });
+		report({ "subpass_gbuffer_frame", "subpasses", 2, subpassBenchmark(engine), "ms" });
+
+		report({ "upload", "bytes", UPLOAD_BUFFER_SIZE * UPLOAD_BUFFERS, uploadBenchmark(engine), "MB/s" });
+
+		const auto [streamed, streamedFrame] = streamingBenchmark(engine);
+		report({ "upload_while_rendering", "draws", STREAM_DRAWS, streamed, "MB/s" });
+		report({ "frame_while_uploading", "draws", STREAM_DRAWS, streamedFrame, "ms/frame" });
+
+		const auto [first, warm] = pipelineBenchmark(engine);
+		report({ "pipeline_creation_first", "iterations", 1, first, "ms" });
+		report({ "pipeline_creation", "iterations", PIPELINE_ITERATIONS, warm, "ms" });
+		report({ "shader_modules", "pipelines", PIPELINE_ITERATIONS, static_cast<double>(engine.getShaderCache().size()), "modules" });
+
+		offscreen_target target(engine, vk::Extent2D{ WIDTH, HEIGTH });
+		const auto resize = [&target](std::size_t i) {
+			target.resize(i % 2 == 0 ? vk::Extent2D{ WIDTH / 2, HEIGTH / 2 } : vk::Extent2D{ WIDTH, HEIGTH });
+		};
+		report({ "offscreen_recreate", "iterations", RECREATE_ITERATIONS, recreateBenchmark(engine, target, resize), "ms" });
+
+		if (engine.getCapabilities().supportsDynamicRendering()) {
+			report({ "offscreen_recreate_dynamic_rendering", "iterations", RECREATE_ITERATIONS, recreateBenchmark(engine, target, resize, true), "ms" });
+		}
+
+		report({ "transient_write", "bytes", TRANSIENT_CONSTANTS_SIZE * TRANSIENT_CONSTANTS, transientBenchmark(engine), "MB/s" });
+
+		report({ "descriptor_update", "updates", DESCRIPTOR_UPDATES, descriptorBenchmark(engine), "updates/s" });
+		report({ "descriptor_allocate", "sets", DESCRIPTOR_UPDATES, descriptorAllocatorBenchmark(engine), "sets/s" });
+
+		if (auto* bindless = engine.getBindless()) {
+			report({ "bindless_update", "updates", DESCRIPTOR_UPDATES, bindlessBenchmark(engine, *bindless), "updates/s" });
+		}
+
+		engine.waitDeviceIdle();
+	}
+
+	// Swapchains need a surface, skipped when no display is available
+	if (glfwInit()) {
+		{
+			glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+			glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+			UniqueGLFWWindow window(glfwCreateWindow(WIDTH, HEIGTH, "Vulkan benchmark", nullptr, nullptr));
+
+			if (window) {
+				engine_vk engine(window.get());
+				swapchain swapChain(engine);
+
+				report({ "swapchain_recreate", "iterations", RECREATE_ITERATIONS, recreateBenchmark(engine, swapChain, [](std::size_t) {}), "ms" });
+
+				engine.waitDeviceIdle();
+			}
+		}
+
+		glfwTerminate();
+	} else {
+		logger_bench->warn("No display available, skipping swapchain_recreate");
+	}
+
+	if (!writeResults(resultsFile, device, results)) {
+		logger_bench->error("Can't write {}!", resultsFile);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
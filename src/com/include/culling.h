@@ -0,0 +1,304 @@
+#ifndef DISPLAY_CULLING_H
+#define DISPLAY_CULLING_H
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// AVX2 needs DISPLAY_AVX2 (or any -mavx2 build), SSE is baseline on x86-64, everything else runs the scalar loop
+#if defined(__AVX2__)
+#define DISPLAY_CULLING_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DISPLAY_CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+namespace culling {
+#if defined(DISPLAY_CULLING_AVX2)
+	constexpr std::size_t LANES = 8;
+#elif defined(DISPLAY_CULLING_SSE)
+	constexpr std::size_t LANES = 4;
+#else
+	constexpr std::size_t LANES = 1;
+#endif
+
+	struct frustum {
+		// Inward facing and normalized, so plane distances are in world units
+		std::array<glm::vec4, 6> planes;
+
+		// Gribb/Hartmann extraction for a Vulkan (0 to 1 depth) view projection matrix
+		static frustum fromViewProjection(const glm::mat4& viewProjection) noexcept {
+			const auto row = [&viewProjection](int i) {
+				return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+			};
+
+			frustum f {{
+				row(3) + row(0), row(3) - row(0),
+				row(3) + row(1), row(3) - row(1),
+				row(2), row(3) - row(2)
+			}};
+
+			for (auto& plane : f.planes) {
+				plane /= glm::length(glm::vec3(plane));
+			}
+
+			return f;
+		};
+	};
+
+	// Structure of arrays, one lane per object so the kernels load several objects per instruction
+	struct sphere_set {
+		std::vector<float> x{};
+		std::vector<float> y{};
+		std::vector<float> z{};
+		std::vector<float> radius{};
+
+		[[nodiscard]] std::size_t size() const noexcept { return this->x.size(); };
+
+		void reserve(std::size_t count) {
+			this->x.reserve(count);
+			this->y.reserve(count);
+			this->z.reserve(count);
+			this->radius.reserve(count);
+		};
+
+		void add(const glm::vec3& center, float r) {
+			this->x.emplace_back(center.x);
+			this->y.emplace_back(center.y);
+			this->z.emplace_back(center.z);
+			this->radius.emplace_back(r);
+		};
+	};
+
+	// Axis aligned boxes as center and half extents
+	struct box_set {
+		std::vector<float> x{};
+		std::vector<float> y{};
+		std::vector<float> z{};
+		std::vector<float> extentX{};
+		std::vector<float> extentY{};
+		std::vector<float> extentZ{};
+
+		[[nodiscard]] std::size_t size() const noexcept { return this->x.size(); };
+
+		void reserve(std::size_t count) {
+			this->x.reserve(count);
+			this->y.reserve(count);
+			this->z.reserve(count);
+			this->extentX.reserve(count);
+			this->extentY.reserve(count);
+			this->extentZ.reserve(count);
+		};
+
+		void add(const glm::vec3& center, const glm::vec3& extent) {
+			this->x.emplace_back(center.x);
+			this->y.emplace_back(center.y);
+			this->z.emplace_back(center.z);
+			this->extentX.emplace_back(extent.x);
+			this->extentY.emplace_back(extent.y);
+			this->extentZ.emplace_back(extent.z);
+		};
+	};
+
+	// Per-object reference tests, the SIMD kernels use them for the tail that doesn't fill a register and sum in the
+	// same order so that both pick exactly the same objects
+	[[nodiscard]] inline bool isVisible(const frustum& f, const glm::vec3& center, float radius) noexcept {
+		for (const auto& plane : f.planes) {
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	[[nodiscard]] inline bool isVisible(const frustum& f, const glm::vec3& center, const glm::vec3& extent) noexcept {
+		for (const auto& plane : f.planes) {
+			const glm::vec3 normal(plane);
+
+			// Distance of the box corner furthest along the plane normal
+			if (glm::dot(normal, center) + plane.w + glm::dot(glm::abs(normal), extent) < 0.0f) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Writes the indices of the visible spheres to visible, in ascending order
+	inline void cull(const frustum& f, const sphere_set& spheres, std::vector<std::uint32_t>& visible) {
+		const auto count = spheres.size();
+
+		visible.resize(count);
+		auto* out = visible.data();
+		std::size_t written = 0;
+		std::size_t i = 0;
+
+#if defined(DISPLAY_CULLING_AVX2)
+		__m256 px[6], py[6], pz[6], pw[6];
+
+		for (std::size_t p = 0; p < 6; ++p) {
+			px[p] = _mm256_set1_ps(f.planes[p].x);
+			py[p] = _mm256_set1_ps(f.planes[p].y);
+			pz[p] = _mm256_set1_ps(f.planes[p].z);
+			pw[p] = _mm256_set1_ps(f.planes[p].w);
+		}
+
+		const auto zero = _mm256_setzero_ps();
+
+		for (; i + 8 <= count; i += 8) {
+			const auto cx = _mm256_loadu_ps(spheres.x.data() + i);
+			const auto cy = _mm256_loadu_ps(spheres.y.data() + i);
+			const auto cz = _mm256_loadu_ps(spheres.z.data() + i);
+			const auto negRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(spheres.radius.data() + i));
+
+			auto inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+
+			for (std::size_t p = 0; p < 6; ++p) {
+				const auto d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], cx), _mm256_mul_ps(py[p], cy)), _mm256_mul_ps(pz[p], cz)), pw[p]);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negRadius, _CMP_GE_OQ));
+			}
+
+			for (auto mask = static_cast<std::uint32_t>(_mm256_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+				out[written++] = static_cast<std::uint32_t>(i + std::countr_zero(mask));
+			}
+		}
+#elif defined(DISPLAY_CULLING_SSE)
+		__m128 px[6], py[6], pz[6], pw[6];
+
+		for (std::size_t p = 0; p < 6; ++p) {
+			px[p] = _mm_set1_ps(f.planes[p].x);
+			py[p] = _mm_set1_ps(f.planes[p].y);
+			pz[p] = _mm_set1_ps(f.planes[p].z);
+			pw[p] = _mm_set1_ps(f.planes[p].w);
+		}
+
+		const auto zero = _mm_setzero_ps();
+
+		for (; i + 4 <= count; i += 4) {
+			const auto cx = _mm_loadu_ps(spheres.x.data() + i);
+			const auto cy = _mm_loadu_ps(spheres.y.data() + i);
+			const auto cz = _mm_loadu_ps(spheres.z.data() + i);
+			const auto negRadius = _mm_sub_ps(zero, _mm_loadu_ps(spheres.radius.data() + i));
+
+			auto inside = _mm_cmpeq_ps(zero, zero);
+
+			for (std::size_t p = 0; p < 6; ++p) {
+				const auto d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], cx), _mm_mul_ps(py[p], cy)), _mm_mul_ps(pz[p], cz)), pw[p]);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+			}
+
+			for (auto mask = static_cast<std::uint32_t>(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+				out[written++] = static_cast<std::uint32_t>(i + std::countr_zero(mask));
+			}
+		}
+#endif
+
+		for (; i < count; ++i) {
+			if (isVisible(f, glm::vec3(spheres.x[i], spheres.y[i], spheres.z[i]), spheres.radius[i])) {
+				out[written++] = static_cast<std::uint32_t>(i);
+			}
+		}
+
+		visible.resize(written);
+	}
+
+	// Writes the indices of the visible boxes to visible, in ascending order
+	inline void cull(const frustum& f, const box_set& boxes, std::vector<std::uint32_t>& visible) {
+		const auto count = boxes.size();
+
+		visible.resize(count);
+		auto* out = visible.data();
+		std::size_t written = 0;
+		std::size_t i = 0;
+
+#if defined(DISPLAY_CULLING_AVX2)
+		__m256 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+
+		for (std::size_t p = 0; p < 6; ++p) {
+			const auto normal = glm::abs(glm::vec3(f.planes[p]));
+
+			px[p] = _mm256_set1_ps(f.planes[p].x);
+			py[p] = _mm256_set1_ps(f.planes[p].y);
+			pz[p] = _mm256_set1_ps(f.planes[p].z);
+			pw[p] = _mm256_set1_ps(f.planes[p].w);
+			ax[p] = _mm256_set1_ps(normal.x);
+			ay[p] = _mm256_set1_ps(normal.y);
+			az[p] = _mm256_set1_ps(normal.z);
+		}
+
+		const auto zero = _mm256_setzero_ps();
+
+		for (; i + 8 <= count; i += 8) {
+			const auto cx = _mm256_loadu_ps(boxes.x.data() + i);
+			const auto cy = _mm256_loadu_ps(boxes.y.data() + i);
+			const auto cz = _mm256_loadu_ps(boxes.z.data() + i);
+			const auto ex = _mm256_loadu_ps(boxes.extentX.data() + i);
+			const auto ey = _mm256_loadu_ps(boxes.extentY.data() + i);
+			const auto ez = _mm256_loadu_ps(boxes.extentZ.data() + i);
+
+			auto inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+
+			for (std::size_t p = 0; p < 6; ++p) {
+				const auto d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], cx), _mm256_mul_ps(py[p], cy)), _mm256_mul_ps(pz[p], cz)), pw[p]);
+				const auto r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)), _mm256_mul_ps(az[p], ez));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_GE_OQ));
+			}
+
+			for (auto mask = static_cast<std::uint32_t>(_mm256_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+				out[written++] = static_cast<std::uint32_t>(i + std::countr_zero(mask));
+			}
+		}
+#elif defined(DISPLAY_CULLING_SSE)
+		__m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+
+		for (std::size_t p = 0; p < 6; ++p) {
+			const auto normal = glm::abs(glm::vec3(f.planes[p]));
+
+			px[p] = _mm_set1_ps(f.planes[p].x);
+			py[p] = _mm_set1_ps(f.planes[p].y);
+			pz[p] = _mm_set1_ps(f.planes[p].z);
+			pw[p] = _mm_set1_ps(f.planes[p].w);
+			ax[p] = _mm_set1_ps(normal.x);
+			ay[p] = _mm_set1_ps(normal.y);
+			az[p] = _mm_set1_ps(normal.z);
+		}
+
+		const auto zero = _mm_setzero_ps();
+
+		for (; i + 4 <= count; i += 4) {
+			const auto cx = _mm_loadu_ps(boxes.x.data() + i);
+			const auto cy = _mm_loadu_ps(boxes.y.data() + i);
+			const auto cz = _mm_loadu_ps(boxes.z.data() + i);
+			const auto ex = _mm_loadu_ps(boxes.extentX.data() + i);
+			const auto ey = _mm_loadu_ps(boxes.extentY.data() + i);
+			const auto ez = _mm_loadu_ps(boxes.extentZ.data() + i);
+
+			auto inside = _mm_cmpeq_ps(zero, zero);
+
+			for (std::size_t p = 0; p < 6; ++p) {
+				const auto d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], cx), _mm_mul_ps(py[p], cy)), _mm_mul_ps(pz[p], cz)), pw[p]);
+				const auto r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero));
+			}
+
+			for (auto mask = static_cast<std::uint32_t>(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+				out[written++] = static_cast<std::uint32_t>(i + std::countr_zero(mask));
+			}
+		}
+#endif
+
+		for (; i < count; ++i) {
+			if (isVisible(f, glm::vec3(boxes.x[i], boxes.y[i], boxes.z[i]), glm::vec3(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]))) {
+				out[written++] = static_cast<std::uint32_t>(i);
+			}
+		}
+
+		visible.resize(written);
+	}
+}
+
+#endif //DISPLAY_CULLING_H
@@ -0,0 +1,15 @@
+#ifndef DISPLAY_ISHOTRELOAD_H
+#define DISPLAY_ISHOTRELOAD_H
+
+
+namespace com {
+#ifdef DISPLAY_HOT_RELOAD
+	constexpr bool isHotReload = true;
+	constexpr const char* shaderSourceDir = DISPLAY_SHADER_SOURCE_DIR;
+#else
+	constexpr bool isHotReload = false;
+	constexpr const char* shaderSourceDir = "";
+#endif
+};
+
+#endif //DISPLAY_ISHOTRELOAD_H
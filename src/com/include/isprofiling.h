@@ -0,0 +1,13 @@
+#ifndef DISPLAY_ISPROFILING_H
+#define DISPLAY_ISPROFILING_H
+
+
+namespace com {
+#ifdef DISPLAY_PROFILING
+	constexpr bool isProfiling = true;
+#else
+	constexpr bool isProfiling = false;
+#endif
+};
+
+#endif //DISPLAY_ISPROFILING_H
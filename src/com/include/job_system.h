@@ -0,0 +1,124 @@
+#ifndef DISPLAY_JOB_SYSTEM_H
+#define DISPLAY_JOB_SYSTEM_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class job_system {
+public:
+	using job = std::function<void(std::size_t worker)>;
+	using slice_job = std::function<void(std::size_t worker, std::size_t slice, std::size_t begin, std::size_t end)>;
+
+private:
+	std::deque<job> queue{};
+	std::mutex mutex;
+	std::condition_variable available;
+	bool stopping = false;
+
+	std::vector<std::thread> workers{};
+
+public:
+	explicit job_system(std::size_t workerCount = std::max(1u, std::thread::hardware_concurrency())) {
+		this->workers.reserve(workerCount);
+
+		for (std::size_t i = 0; i < workerCount; ++i) {
+			this->workers.emplace_back([this, i]() { run(i); });
+		}
+	};
+
+	~job_system() {
+		{
+			std::scoped_lock lock(this->mutex);
+			this->stopping = true;
+		}
+
+		this->available.notify_all();
+
+		for (auto& worker : this->workers) {
+			worker.join();
+		}
+	};
+
+	job_system(const job_system&) = delete;
+	job_system& operator=(const job_system&) = delete;
+
+	[[nodiscard]] std::size_t getWorkerCount() const noexcept { return this->workers.size(); };
+
+	void push(job j) {
+		{
+			std::scoped_lock lock(this->mutex);
+			this->queue.emplace_back(std::move(j));
+		}
+
+		this->available.notify_one();
+	};
+
+	// Splits [0, count) into at most one contiguous slice per worker and blocks until all of them ran, returns the slice count
+	std::size_t parallelFor(std::size_t count, const slice_job& fn) {
+		const auto slices = std::min(count, this->workers.size());
+
+		if (slices == 0) {
+			return 0;
+		}
+
+		std::latch done(static_cast<std::ptrdiff_t>(slices));
+		std::mutex errorMutex;
+		std::exception_ptr error;
+
+		for (std::size_t slice = 0; slice < slices; ++slice) {
+			const auto begin = count * slice / slices;
+			const auto end = count * (slice + 1) / slices;
+
+			push([&fn, &done, &errorMutex, &error, slice, begin, end](std::size_t worker) {
+				try {
+					fn(worker, slice, begin, end);
+				} catch (...) {
+					std::scoped_lock lock(errorMutex);
+					if (!error) {
+						error = std::current_exception();
+					}
+				}
+
+				done.count_down();
+			});
+		}
+
+		done.wait();
+
+		if (error) {
+			std::rethrow_exception(error);
+		}
+
+		return slices;
+	};
+
+private:
+	void run(std::size_t worker) {
+		for (;;) {
+			job j;
+
+			{
+				std::unique_lock lock(this->mutex);
+				this->available.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+
+				if (this->stopping && this->queue.empty()) {
+					return;
+				}
+
+				j = std::move(this->queue.front());
+				this->queue.pop_front();
+			}
+
+			j(worker);
+		}
+	};
+};
+
+#endif //DISPLAY_JOB_SYSTEM_H
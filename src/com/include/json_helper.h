@@ -0,0 +1,36 @@
+#ifndef DISPLAY_JSON_HELPER_H
+#define DISPLAY_JSON_HELPER_H
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace com {
+	// Contents of a JSON string literal, the surrounding quotes are left to the caller
+	inline std::string jsonEscape(std::string_view text) {
+		std::string escaped;
+		escaped.reserve(text.size());
+
+		for (const auto c : text) {
+			switch (c) {
+				case '"': escaped += "\\\""; break;
+				case '\\': escaped += "\\\\"; break;
+				case '\n': escaped += "\\n"; break;
+				case '\r': escaped += "\\r"; break;
+				case '\t': escaped += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20) {
+						char code[7];
+						std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned int>(c));
+						escaped += code;
+					} else {
+						escaped += c;
+					}
+			}
+		}
+
+		return escaped;
+	}
+};
+
+#endif //DISPLAY_JSON_HELPER_H
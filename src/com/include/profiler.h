@@ -0,0 +1,243 @@
+#ifndef DISPLAY_PROFILER_H
+#define DISPLAY_PROFILER_H
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "isprofiling.h"
+#include "json_helper.h"
+
+class profiler {
+public:
+	using clock = std::chrono::steady_clock;
+
+	enum class track : std::uint32_t { cpu, gpu };
+
+	struct percentiles {
+		std::size_t samples;
+		double p50;
+		double p95;
+		double p99;
+	};
+
+	// Percentiles cover the most recent WINDOW samples per scope, the trace keeps at most MAX_EVENTS events
+	constexpr static std::size_t WINDOW = 1024;
+	constexpr static std::size_t MAX_EVENTS = 1 << 20;
+
+	constexpr static auto TRACE_FILE = "profile_trace.json";
+	constexpr static auto CSV_FILE = "profile.csv";
+
+private:
+	struct scope_stats {
+		std::string name;
+		track where;
+		std::vector<double> window{};
+		std::size_t next = 0;
+	};
+
+	struct event {
+		std::uint32_t scope;
+		std::uint32_t thread;
+		std::uint64_t frame;
+		double startUs;
+		double durationUs;
+	};
+
+	mutable std::mutex mutex;
+	const clock::time_point epoch = clock::now();
+
+	std::vector<scope_stats> scopes{};
+	std::unordered_map<std::string, std::uint32_t> lookup{};
+	std::vector<event> events{};
+	std::uint64_t frame = 0;
+
+	profiler() = default;
+
+public:
+	static profiler& get() {
+		static profiler instance;
+		return instance;
+	};
+
+	[[nodiscard]] double toMicroseconds(clock::time_point time) const noexcept {
+		return std::chrono::duration<double, std::micro>(time - this->epoch).count();
+	};
+
+	void nextFrame() noexcept {
+		std::scoped_lock lock(this->mutex);
+		++this->frame;
+	};
+
+	void record(track where, std::string_view name, double startUs, double durationUs) {
+		std::scoped_lock lock(this->mutex);
+
+		const auto scope = scopeIndex(where, name);
+		auto& stats = this->scopes[scope];
+
+		if (stats.window.size() < profiler::WINDOW) {
+			stats.window.emplace_back(durationUs);
+		} else {
+			stats.window[stats.next] = durationUs;
+		}
+		stats.next = (stats.next + 1) % profiler::WINDOW;
+
+		if (this->events.size() < profiler::MAX_EVENTS) {
+			// GPU scopes are collected on whichever thread polls the queries, keep them on a single track
+			const auto thread = where == track::gpu ? 0 : static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			this->events.emplace_back(event{ scope, thread, this->frame, startUs, durationUs });
+		}
+	};
+
+	[[nodiscard]] std::optional<percentiles> getPercentiles(track where, std::string_view name) const {
+		std::scoped_lock lock(this->mutex);
+
+		const auto it = this->lookup.find(key(where, name));
+
+		if (it == this->lookup.end()) {
+			return {};
+		}
+
+		return computePercentiles(this->scopes[it->second]);
+	};
+
+	void logSummary(const std::shared_ptr<spdlog::logger>& logger) const {
+		std::scoped_lock lock(this->mutex);
+
+		for (const auto& stats : this->scopes) {
+			const auto p = computePercentiles(stats);
+			logger->info("{} {}: p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms ({} samples)",
+						 trackName(stats.where), stats.name, p.p50 / 1000.0, p.p95 / 1000.0, p.p99 / 1000.0, p.samples);
+		}
+	};
+
+	// Chrome trace event format, load through chrome://tracing or ui.perfetto.dev
+	bool writeChromeTrace(const std::string& filename) const {
+		std::scoped_lock lock(this->mutex);
+
+		std::ofstream output(filename);
+
+		if (!output.good()) {
+			return false;
+		}
+
+		output << "{\"traceEvents\":[";
+
+		for (std::size_t i = 0; i < this->events.size(); ++i) {
+			const auto& e = this->events[i];
+			const auto& stats = this->scopes[e.scope];
+
+			output << (i == 0 ? "" : ",") << "\n"
+				   << "{\"name\":\"" << com::jsonEscape(stats.name) << "\",\"cat\":\"" << trackName(stats.where) << "\",\"ph\":\"X\""
+				   << ",\"ts\":" << e.startUs << ",\"dur\":" << e.durationUs
+				   << ",\"pid\":" << (stats.where == track::cpu ? 1 : 2) << ",\"tid\":" << e.thread
+				   << ",\"args\":{\"frame\":" << e.frame << "}}";
+		}
+
+		output << "\n]}\n";
+
+		return output.good();
+	};
+
+	bool writeCsv(const std::string& filename) const {
+		std::scoped_lock lock(this->mutex);
+
+		std::ofstream output(filename);
+
+		if (!output.good()) {
+			return false;
+		}
+
+		output << "track,scope,samples,p50_ms,p95_ms,p99_ms\n";
+
+		for (const auto& stats : this->scopes) {
+			const auto p = computePercentiles(stats);
+			output << trackName(stats.where) << "," << stats.name << "," << p.samples << ","
+				   << p.p50 / 1000.0 << "," << p.p95 / 1000.0 << "," << p.p99 / 1000.0 << "\n";
+		}
+
+		return output.good();
+	};
+
+	// Per run summary: percentiles to the log and CSV_FILE, every event to TRACE_FILE
+	void writeReport(const std::shared_ptr<spdlog::logger>& logger) const {
+		logSummary(logger);
+
+		if (!writeCsv(profiler::CSV_FILE)) {
+			logger->warn("Can't write {}!", profiler::CSV_FILE);
+		}
+
+		if (!writeChromeTrace(profiler::TRACE_FILE)) {
+			logger->warn("Can't write {}!", profiler::TRACE_FILE);
+		}
+	};
+
+private:
+	[[nodiscard]] static std::string key(track where, std::string_view name) {
+		return std::string(trackName(where)) + "/" + std::string(name);
+	};
+
+	[[nodiscard]] static std::string_view trackName(track where) noexcept {
+		return where == track::cpu ? "cpu" : "gpu";
+	};
+
+	std::uint32_t scopeIndex(track where, std::string_view name) {
+		const auto [it, inserted] = this->lookup.try_emplace(key(where, name), static_cast<std::uint32_t>(this->scopes.size()));
+
+		if (inserted) {
+			this->scopes.emplace_back(scope_stats{ std::string(name), where });
+		}
+
+		return it->second;
+	};
+
+	[[nodiscard]] static percentiles computePercentiles(const scope_stats& stats) {
+		auto sorted = stats.window;
+		std::sort(sorted.begin(), sorted.end());
+
+		const auto at = [&sorted](double q) {
+			return sorted.empty() ? 0.0 : sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(q * static_cast<double>(sorted.size())))];
+		};
+
+		return { sorted.size(), at(0.50), at(0.95), at(0.99) };
+	};
+};
+
+// Times the enclosing scope on the CPU track, compiles to nothing unless DISPLAY_PROFILING is defined
+class profile_scope {
+private:
+	std::string_view name;
+	profiler::clock::time_point start;
+
+public:
+	explicit profile_scope(std::string_view name) noexcept {
+		if constexpr (com::isProfiling) {
+			this->name = name;
+			static_cast<void>(profiler::get()); // Pin the epoch before the first scope starts
+			this->start = profiler::clock::now();
+		}
+	};
+
+	~profile_scope() {
+		if constexpr (com::isProfiling) {
+			const auto end = profiler::clock::now();
+			auto& p = profiler::get();
+			p.record(profiler::track::cpu, this->name, p.toMicroseconds(this->start), std::chrono::duration<double, std::micro>(end - this->start).count());
+		}
+	};
+
+	profile_scope(const profile_scope&) = delete;
+	profile_scope& operator=(const profile_scope&) = delete;
+};
+
+#endif //DISPLAY_PROFILER_H
@@ -1,23 +1,43 @@
+#include <charconv>
 #include <cstdlib>
+#include <string>
+#include <string_view>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
+#include <app_headless.h>
 #include <app_vk.h>
 
 #include <isdebug.h>
 
 constexpr int WIDTH = 1920;
 constexpr int HEIGTH = 1080;
+constexpr std::size_t HEADLESS_FRAMES = 100;
 
 void error_callback(int error, const char* description)
 {
 	spdlog::get("glfw")->error("Error {}: {}", error, description);
 }
 
-int main() {
+// Renders a fixed number of frames offscreen without GLFW, optionally saving the last one as PPM
+int runHeadless(std::size_t frames, const char* output) {
+	app_headless app(WIDTH, HEIGTH);
+
+	for (std::size_t i = 0; i < frames; ++i) {
+		app.drawFrame();
+	}
+
+	if (output && !app.writeFrame(output)) {
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
 	auto logger_glfw = spdlog::stdout_color_mt("glfw");
 	auto logger_graphics = spdlog::stdout_color_mt("graphics");
 
@@ -26,6 +46,23 @@ int main() {
 		logger_graphics->set_level(spdlog::level::debug);
 	}
 
+	// display_vk --headless [frames] [output.ppm]
+	if (argc > 1 && std::string_view(argv[1]) == "--headless") {
+		std::size_t frames = HEADLESS_FRAMES;
+
+		if (argc > 2) {
+			const std::string_view argument(argv[2]);
+			const auto [end, error] = std::from_chars(argument.data(), argument.data() + argument.size(), frames);
+
+			if (error != std::errc() || end != argument.data() + argument.size()) {
+				spdlog::get("graphics")->error("Usage: {} --headless [frames] [output.ppm]", argv[0]);
+				return EXIT_FAILURE;
+			}
+		}
+
+		return runHeadless(frames, argc > 3 ? argv[3] : nullptr);
+	}
+
 	glfwSetErrorCallback(error_callback);
 
 	if (!glfwInit()) {
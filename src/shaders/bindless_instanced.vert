@@ -0,0 +1,17 @@
+#version 450 core
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 inVert;
+
+// Global bindless table, binding 0 holds every registered storage buffer
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    mat4 transforms[];
+} buffers[];
+
+layout(push_constant) uniform Constants {
+    uint transformBuffer;
+};
+
+void main(void) {
+    gl_Position = buffers[transformBuffer].transforms[gl_InstanceIndex] * vec4(inVert, 1.0f);
+}
@@ -0,0 +1,11 @@
+#version 450 core
+
+layout(location = 0) in vec3 inVert;
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    mat4 transforms[];
+};
+
+void main(void) {
+    gl_Position = transforms[gl_InstanceIndex] * vec4(inVert, 1.0f);
+}
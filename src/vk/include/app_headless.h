@@ -0,0 +1,26 @@
+#ifndef DISPLAY_APP_HEADLESS_H
+#define DISPLAY_APP_HEADLESS_H
+
+#include "engine_vk.h"
+#include "offscreen_target.h"
+#include "triangle_renderer.h"
+
+#include <string>
+
+class app_headless {
+private:
+	std::unique_ptr<engine_vk> engine;
+	std::unique_ptr<triangle_renderer> field;
+	offscreen_target* target;
+
+public:
+	app_headless(int width, int height);
+	~app_headless();
+
+	void drawFrame() noexcept;
+
+	// Writes the most recently presented frame as a binary PPM, false if nothing was presented or the file can't be written
+	[[nodiscard]] bool writeFrame(const std::string& filename) const;
+};
+
+#endif //DISPLAY_APP_HEADLESS_H
@@ -3,6 +3,7 @@
 
 #include <app_com.h>
 #include "engine_vk.h"
+#include "swapchain.h"
 #include "triangle_renderer.h"
 
 class app_vk : public app_com {
@@ -0,0 +1,68 @@
+#ifndef DISPLAY_BINDLESS_TABLE_H
+#define DISPLAY_BINDLESS_TABLE_H
+
+#include "engine_vk.h"
+
+#include <mutex>
+#include <utility>
+
+// One update-after-bind descriptor set shared by every pipeline, shaders index into its arrays instead of binding per draw
+class bindless_table {
+public:
+	constexpr static std::uint32_t MAX_BUFFERS = 64 * 1024;
+	constexpr static std::uint32_t MAX_IMAGES = 16 * 1024;
+
+	// Binding numbers in the global set, shaders declare the same unsized arrays
+	enum class kind : std::uint32_t {
+		buffer = 0,
+		image = 1
+	};
+
+	using index = std::uint32_t;
+
+private:
+	// Returns a slot to its free list once the GPU finished every submission that could still read it
+	class slot_release {
+	private:
+		bindless_table* table;
+		kind slotKind;
+		index slot;
+	public:
+		slot_release(bindless_table* table, kind slotKind, index slot) : table(table), slotKind(slotKind), slot(slot) {};
+		slot_release(slot_release&& other) noexcept : table(std::exchange(other.table, nullptr)), slotKind(other.slotKind), slot(other.slot) {};
+		slot_release(const slot_release&) = delete;
+		~slot_release() { if (this->table) this->table->release(this->slotKind, this->slot); };
+	};
+
+	struct slots {
+		std::uint32_t capacity;
+		std::uint32_t next = 0;
+		std::vector<index> free{};
+	};
+
+	const engine_vk& engine;
+
+	vk::UniqueDescriptorSetLayout descriptorLayout;
+	vk::UniqueDescriptorPool descriptorPool;
+	vk::DescriptorSet descriptorSet;
+
+	std::array<slots, 2> tables;
+	std::mutex mutex;
+
+public:
+	explicit bindless_table(const engine_vk& engine);
+
+	[[nodiscard]] index addBuffer(const vk::Buffer& buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+	[[nodiscard]] index addImage(const vk::ImageView& view, const vk::Sampler& sampler, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+	void remove(kind slotKind, index slot);
+
+	[[nodiscard]] const vk::DescriptorSetLayout& layout() const noexcept { return this->descriptorLayout.get(); };
+	[[nodiscard]] const vk::DescriptorSet& set() const noexcept { return this->descriptorSet; };
+	[[nodiscard]] std::uint32_t capacity(kind slotKind) const noexcept { return this->tables[static_cast<std::uint32_t>(slotKind)].capacity; };
+
+private:
+	index acquire(kind slotKind);
+	void release(kind slotKind, index slot);
+};
+
+#endif //DISPLAY_BINDLESS_TABLE_H
@@ -0,0 +1,34 @@
+#ifndef DISPLAY_COMMAND_CACHE_H
+#define DISPLAY_COMMAND_CACHE_H
+
+#include "engine_vk.h"
+
+#include <functional>
+
+class command_cache {
+private:
+	const engine_vk& engine;
+	const vk::CommandBufferLevel level;
+
+	std::vector<vk::UniqueCommandBuffer> buffers{};
+	std::vector<bool> dirty{};
+	std::vector<bool> recorded{}; // False for buffers fresh from resize, they can't be pending
+
+public:
+	command_cache(const engine_vk& engine, vk::CommandBufferLevel level, std::size_t count);
+
+	void resize(std::size_t count);
+	void invalidate() noexcept;
+	void invalidate(std::size_t index) noexcept;
+
+	[[nodiscard]] bool isDirty(std::size_t index) const noexcept { return this->dirty[index]; };
+	[[nodiscard]] bool anyDirty() const noexcept;
+	// Re-recording these in place requires that no submission using them is still pending
+	[[nodiscard]] bool anyDirtyRecorded() const noexcept;
+	[[nodiscard]] std::size_t size() const noexcept { return this->buffers.size(); };
+
+	// Re-records the buffer through the lambda only if it was invalidated, the lambda is responsible for begin/end
+	const vk::UniqueCommandBuffer& get(std::size_t index, const std::function<void(const vk::UniqueCommandBuffer&)>& record);
+};
+
+#endif //DISPLAY_COMMAND_CACHE_H
@@ -0,0 +1,18 @@
+#ifndef DISPLAY_COMPUTE_PIPELINE_H
+#define DISPLAY_COMPUTE_PIPELINE_H
+
+#include "pipeline.h"
+
+// Single compute shader, descriptor sets and push constants are set up through pipeline like for graphics
+class compute_pipeline : public pipeline {
+public:
+	compute_pipeline(const engine_vk& engine, const std::string& shader);
+
+	void finalize();
+	void dispatch(const vk::CommandBuffer& buffer, std::uint32_t groupsX, std::uint32_t groupsY = 1, std::uint32_t groupsZ = 1) const;
+
+protected:
+	[[nodiscard]] std::function<vk::UniquePipeline()> builder(const std::vector<vk::PipelineShaderStageCreateInfo>& stages) const override;
+};
+
+#endif //DISPLAY_COMPUTE_PIPELINE_H
@@ -0,0 +1,58 @@
+#ifndef DISPLAY_DESCRIPTOR_ALLOCATOR_H
+#define DISPLAY_DESCRIPTOR_ALLOCATOR_H
+
+#include "engine_vk.h"
+
+#include <mutex>
+
+// Per-frame descriptor sets for dynamic per-draw bindings, whole pools are reset instead of freeing sets one by one
+class descriptor_allocator {
+public:
+	constexpr static std::uint32_t INITIAL_SETS = 64;
+	constexpr static std::uint32_t MAX_SETS = 4096;
+
+	// Descriptors of a type per set, scaled by the sets a pool holds
+	struct pool_ratio {
+		vk::DescriptorType type;
+		float perSet;
+	};
+
+private:
+	struct pool {
+		vk::UniqueDescriptorPool descriptorPool;
+		std::uint32_t maxSets;
+	};
+
+	const engine_vk& engine;
+
+	std::vector<pool_ratio> ratios;
+
+	// Pools handed to each frame slot, reset together once the slot comes around again
+	std::vector<std::vector<pool>> framePools;
+	std::vector<pool> freePools{};
+	std::uint32_t nextSets = INITIAL_SETS;
+
+	std::size_t frame = 0;
+	mutable std::mutex mutex;
+
+public:
+	descriptor_allocator(const engine_vk& engine, std::size_t frames, std::vector<pool_ratio> ratios = {
+		{ vk::DescriptorType::eUniformBuffer, 2.0f },
+		{ vk::DescriptorType::eUniformBufferDynamic, 1.0f },
+		{ vk::DescriptorType::eStorageBuffer, 2.0f },
+		{ vk::DescriptorType::eCombinedImageSampler, 2.0f }
+	});
+
+	// Recycles the slot's pools, the GPU must be done with the last frame that used it
+	void beginFrame(std::size_t frameSlot);
+
+	// Grows by a larger pool whenever the current one runs out, valid until the slot's next beginFrame
+	[[nodiscard]] vk::DescriptorSet allocate(const vk::DescriptorSetLayout& layout);
+
+	[[nodiscard]] std::size_t getPoolCount() const;
+
+private:
+	pool takePool();
+};
+
+#endif //DISPLAY_DESCRIPTOR_ALLOCATOR_H
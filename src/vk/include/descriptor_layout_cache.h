@@ -0,0 +1,36 @@
+#ifndef DISPLAY_DESCRIPTOR_LAYOUT_CACHE_H
+#define DISPLAY_DESCRIPTOR_LAYOUT_CACHE_H
+
+#include <vulkan/vulkan.hpp>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Hands out one DescriptorSetLayout per distinct binding list, so pipelines with the same interface share it
+class descriptor_layout_cache {
+private:
+	struct layout_key {
+		vk::DescriptorSetLayoutCreateFlags flags;
+		std::vector<vk::DescriptorSetLayoutBinding> bindings;
+
+		bool operator==(const layout_key& other) const noexcept { return this->flags == other.flags && this->bindings == other.bindings; };
+	};
+
+	struct layout_key_hash {
+		std::size_t operator()(const layout_key& key) const noexcept;
+	};
+
+	vk::Device device;
+
+	std::unordered_map<layout_key, vk::UniqueDescriptorSetLayout, layout_key_hash> layouts{};
+	mutable std::mutex mutex;
+
+public:
+	explicit descriptor_layout_cache(const vk::Device& device) : device(device) {};
+
+	// Valid until the cache is destroyed together with the engine, binding order doesn't matter
+	[[nodiscard]] vk::DescriptorSetLayout get(std::vector<vk::DescriptorSetLayoutBinding> bindings, const vk::DescriptorSetLayoutCreateFlags& flags = {});
+	[[nodiscard]] std::size_t size() const;
+};
+
+#endif //DISPLAY_DESCRIPTOR_LAYOUT_CACHE_H
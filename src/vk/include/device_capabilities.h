@@ -0,0 +1,56 @@
+#ifndef DISPLAY_DEVICE_CAPABILITIES_H
+#define DISPLAY_DEVICE_CAPABILITIES_H
+
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Everything queried from a physical device once, so hot paths never go back to the driver
+class device_capabilities {
+public:
+	enum class memory_usage : std::size_t {
+		device_local, // GPU only resources
+		upload,       // Host writes, GPU reads: staging, per-frame constants
+		readback,     // GPU writes, host reads
+		rebar,        // Host writes straight into VRAM, falls back to upload without resizable BAR
+		transient,    // Attachments that never leave tile memory, lazily allocated where supported, else device local
+		count
+	};
+
+	vk::PhysicalDevice device;
+	vk::PhysicalDeviceProperties properties;
+	vk::PhysicalDeviceFeatures features;
+	vk::PhysicalDeviceVulkan12Features features12{}; // All false on pre 1.2 devices
+	vk::PhysicalDeviceVulkan12Properties properties12{};
+	bool dynamicRendering = false; // VK_KHR_dynamic_rendering extension and feature
+	vk::PhysicalDeviceMemoryProperties memory;
+	std::vector<vk::QueueFamilyProperties> queueFamilies;
+	std::vector<vk::ExtensionProperties> extensions;
+
+private:
+	// Candidate memory types per usage, best first
+	std::array<std::vector<std::uint32_t>, static_cast<std::size_t>(memory_usage::count)> preferredTypes{};
+
+public:
+	explicit device_capabilities(const vk::PhysicalDevice& device);
+
+	[[nodiscard]] const vk::PhysicalDeviceLimits& limits() const noexcept { return this->properties.limits; };
+	[[nodiscard]] bool supportsExtension(std::string_view name) const noexcept;
+	[[nodiscard]] bool hasRebar() const noexcept;
+	[[nodiscard]] bool hasLazyMemory() const noexcept;
+	[[nodiscard]] bool supportsBindless() const noexcept;
+	[[nodiscard]] bool supportsDynamicRendering() const noexcept { return this->dynamicRendering; };
+
+	[[nodiscard]] std::optional<std::uint32_t> findMemoryType(memory_usage usage, std::uint32_t typeFilter) const noexcept;
+
+	void log() const;
+
+private:
+	[[nodiscard]] std::optional<int> score(memory_usage usage, std::uint32_t type) const noexcept;
+	[[nodiscard]] vk::DeviceSize heapSize(std::uint32_t type) const noexcept { return this->memory.memoryHeaps[this->memory.memoryTypes[type].heapIndex].size; };
+};
+
+#endif //DISPLAY_DEVICE_CAPABILITIES_H
@@ -0,0 +1,31 @@
+#ifndef DISPLAY_DYNAMIC_RENDERING_H
+#define DISPLAY_DYNAMIC_RENDERING_H
+
+#include "render_target.h"
+
+// Renders straight into the target's image views through VK_KHR_dynamic_rendering, no render pass or framebuffer
+// objects exist, so resizing the target only needs the pipelines rebuilt when the format changes
+class dynamic_rendering {
+private:
+	const engine_vk& engine;
+	const render_target& target;
+
+	vk::Format colorFormat;
+	vk::CommandBufferInheritanceRenderingInfoKHR cbiri{};
+
+public:
+	dynamic_rendering(const engine_vk& engine, const render_target& target);
+
+	[[nodiscard]] bool updateFormat() noexcept;
+	[[nodiscard]] std::vector<vk::Format> getColorFormats() const { return { this->colorFormat }; };
+
+	// Transitions the image to an attachment, the render pass did that through its initial layout and external dependency
+	void begin(const vk::CommandBuffer& buffer, const vk::Image& image, const vk::ImageView& view, const vk::Rect2D& renderArea, const vk::ClearValue& clearValue, vk::RenderingFlagsKHR flags = {}) const;
+	// Leaves the image in the target's final layout
+	void end(const vk::CommandBuffer& buffer, const vk::Image& image) const;
+
+	// Chains the attachment formats the secondary buffer is executed with, cbii must not outlive this object
+	void inherit(vk::CommandBufferInheritanceInfo& cbii) const noexcept;
+};
+
+#endif //DISPLAY_DYNAMIC_RENDERING_H
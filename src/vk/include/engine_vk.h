@@ -2,40 +2,82 @@
 #define DISPLAY_ENGINE_VK_H
 
 #include <vulkan/vulkan.hpp>
+#include <array>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
 
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 
+#include "descriptor_layout_cache.h"
+#include "device_capabilities.h"
+#include "memory_allocator.h"
+#include "shader_module_cache.h"
+#include "upload_ticket.h"
+
+class staging_uploader;
+class bindless_table;
+
 using UniqueSurfaceKHR = std::unique_ptr<vk::SurfaceKHR, std::function<void (vk::SurfaceKHR*)>>;
 
 class engine_vk {
 	friend class swapchain;
 	friend class pipeline;
+	friend class compute_pipeline;
 	friend class renderpass;
 	friend class gui;
+	friend class gpu_profiler;
+	friend class staging_uploader;
+	friend class bindless_table;
+	friend class descriptor_allocator;
+	friend class render_graph;
+	friend class dynamic_rendering;
 public:
+	constexpr static auto PIPELINE_CACHE_FILE = "pipeline_cache.bin";
+
+	using memory_usage = device_capabilities::memory_usage;
+
 	class vk_buffer {
 	public:
-		vk::UniqueDeviceMemory memory;
+		memory_allocator::allocation memory;
 		vk::UniqueBuffer buffer;
 	public:
 		vk_buffer() = default;
-		vk_buffer(vk::UniqueDeviceMemory& memory, vk::UniqueBuffer& buffer) : memory(std::move(memory)), buffer(std::move(buffer)) {};
+		vk_buffer(memory_allocator::allocation& memory, vk::UniqueBuffer& buffer) : memory(std::move(memory)), buffer(std::move(buffer)) {};
+
+		// Stable for the buffer's lifetime when it lives in host visible memory, flush after writing and invalidate before reading
+		[[nodiscard]] void* data() const noexcept { return this->memory.getMapped(); };
+		void flush(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE) const { this->memory.flush(offset, size); };
+		void invalidate(vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE) const { this->memory.invalidate(offset, size); };
 	};
 
-	class memory_mapping {
-	private:
-		const engine_vk& engine;
-		const vk::DeviceMemory& memory;
-		void* data;
+	// Makes a submission wait until a queue's timeline reached value, also across queues
+	struct timeline_wait {
+		vk::QueueFlagBits family;
+		std::uint64_t value;
+		vk::PipelineStageFlags stage;
+	};
+
+	// One SubmitInfo, binary semaphores are only needed for swapchain acquire and present
+	struct submission {
+		std::vector<vk::CommandBuffer> cmdBuffers{};
+		std::vector<timeline_wait> timelineWaits{};
+		std::vector<vk::Semaphore> waitSemaphores{};
+		std::vector<vk::PipelineStageFlags> waitStages{};
+		std::vector<vk::Semaphore> signalSemaphores{};
+	};
+
+	class vk_image {
 	public:
-		memory_mapping(const engine_vk& engine, const vk::DeviceMemory& memory, vk::DeviceSize offset, vk::DeviceSize size): engine(engine), memory(memory) {
-			this->data = this->engine.logicalDevice->mapMemory(this->memory, offset, size);
-		};
-		~memory_mapping() { this->engine.logicalDevice->unmapMemory(memory); };
-		[[nodiscard]] void* get() const noexcept { return this->data; };
+		memory_allocator::allocation memory;
+		vk::UniqueImage image;
+		vk::UniqueImageView view;
+	public:
+		vk_image() = default;
+		vk_image(memory_allocator::allocation& memory, vk::UniqueImage& image, vk::UniqueImageView& view) : memory(std::move(memory)), image(std::move(image)), view(std::move(view)) {};
 	};
 
 private:
@@ -49,6 +91,7 @@ private:
 	UniqueSurfaceKHR surface;
 
 	vk::PhysicalDevice physicalDevice;
+	std::unique_ptr<device_capabilities> capabilities;
 	vk::UniqueDevice logicalDevice;
 
 	std::uint32_t graphicsFamilyIndex;
@@ -59,35 +102,103 @@ private:
 	vk::Queue transferQueue;
 	vk::UniqueCommandPool transferPool;
 
+	// Timeline semaphore per queue family, every submission signals the next value
+	struct queue_timeline {
+		vk::UniqueSemaphore semaphore;
+		std::uint64_t submitted = 0;
+	};
+
+	mutable std::array<queue_timeline, 2> timelines{};
+	mutable std::mutex queueMutex;
+
+	vk::UniquePipelineCache pipelineCache;
+
+	std::unique_ptr<memory_allocator> allocator;
+	std::unique_ptr<descriptor_layout_cache> layoutCache;
+	std::unique_ptr<shader_module_cache> shaderCache;
+	std::unique_ptr<staging_uploader> uploader;
+	std::unique_ptr<bindless_table> bindless;
+
+	// Destroyed once both timelines passed the values submitted when the resource was retired
+	struct retired_resource {
+		std::array<std::uint64_t, 2> values;
+		std::shared_ptr<void> resource;
+	};
+
+	// Declared after the allocator so that retired memory is returned before the allocator goes away
+	mutable std::deque<retired_resource> retiredResources{};
+	mutable std::mutex retireMutex;
+
 public:
-	explicit engine_vk(GLFWwindow* window);
+	// Without a window the engine runs headless: no surface, no swapchain extension and any device type is accepted
+	explicit engine_vk(GLFWwindow* window = nullptr);
+	~engine_vk();
+
+	[[nodiscard]] bool isHeadless() const noexcept { return this->window == nullptr; };
+	[[nodiscard]] std::string getDeviceName() const;
+	[[nodiscard]] const device_capabilities& getCapabilities() const noexcept { return *this->capabilities; };
 
-	[[nodiscard]] vk::UniqueShaderModule createShaderModule(const std::string &filename) const;
 	[[nodiscard]] vk::UniqueSemaphore createSemaphore() const;
 	[[nodiscard]] vk::UniqueFence createFence(vk::FenceCreateFlagBits flags = {}) const;
+	[[nodiscard]] vk::UniqueCommandPool createCommandPool(const vk::QueueFlagBits& family, const vk::CommandPoolCreateFlags& flags = {}) const;
+	void resetCommandPool(const vk::CommandPool& pool) const;
 	[[nodiscard]] std::vector<vk::UniqueCommandBuffer> allocateCmdBuffers(const vk::QueueFlagBits& family, const vk::CommandBufferLevel& level, std::size_t count) const;
-	[[nodiscard]] vk_buffer createBuffer(vk::DeviceSize size, const vk::BufferUsageFlags& usage, const vk::MemoryPropertyFlags& properties) const;
-	[[nodiscard]] vk_buffer createLocalBufferWithData(vk::DeviceSize size, vk::BufferUsageFlagBits usage, const void *dataPointer) const;
+	[[nodiscard]] std::vector<vk::UniqueCommandBuffer> allocateCmdBuffers(const vk::CommandPool& pool, const vk::CommandBufferLevel& level, std::size_t count) const;
+	[[nodiscard]] vk_buffer createBuffer(vk::DeviceSize size, const vk::BufferUsageFlags& usage, memory_usage memoryUsage) const;
+	[[nodiscard]] vk_image createImage(const vk::Extent2D& extent, vk::Format format, const vk::ImageUsageFlags& usage, memory_usage memoryUsage, const vk::ImageAspectFlags& aspect = vk::ImageAspectFlagBits::eColor) const;
+	// The contents are only valid on the GPU once the ticket is ready, it joins the uploader's current batch
+	[[nodiscard]] std::pair<vk_buffer, upload_ticket> createLocalBufferWithData(vk::DeviceSize size, vk::BufferUsageFlagBits usage, const void *dataPointer) const;
 	void updateDescriptorSets(const vk::WriteDescriptorSet& wds) const noexcept;
+	void updateDescriptorSets(const std::vector<vk::WriteDescriptorSet>& writes) const noexcept;
+	// Entries read their descriptor infos from a caller struct, one call then writes the whole set
+	[[nodiscard]] vk::UniqueDescriptorUpdateTemplate createUpdateTemplate(const vk::DescriptorSetLayout& layout, const std::vector<vk::DescriptorUpdateTemplateEntry>& entries) const;
+	void updateDescriptorSet(const vk::DescriptorSet& set, const vk::DescriptorUpdateTemplate& updateTemplate, const void* data) const noexcept;
+	[[nodiscard]] descriptor_layout_cache& getLayoutCache() const noexcept { return *this->layoutCache; };
+	[[nodiscard]] shader_module_cache& getShaderCache() const noexcept { return *this->shaderCache; };
+	[[nodiscard]] const memory_allocator& getAllocator() const noexcept { return *this->allocator; };
+	[[nodiscard]] staging_uploader& getUploader() const noexcept { return *this->uploader; };
+	// Null when the device lacks the descriptor indexing features
+	[[nodiscard]] bindless_table* getBindless() const noexcept { return this->bindless.get(); };
+
+	// Submits all batches in one queue call, returns the timeline value signaled by the last one
+	std::uint64_t submit(const vk::QueueFlagBits& family, const std::vector<submission>& submissions) const;
+	[[nodiscard]] std::uint64_t submittedValue(const vk::QueueFlagBits& family) const noexcept;
+	[[nodiscard]] std::uint64_t completedValue(const vk::QueueFlagBits& family) const;
+	[[nodiscard]] bool isComplete(const vk::QueueFlagBits& family, std::uint64_t value) const { return completedValue(family) >= value; };
+	void waitTimeline(const vk::QueueFlagBits& family, std::uint64_t value) const noexcept;
+
+	// Keeps the resource alive until every submission made so far completed, instead of waiting for the device to idle
+	template<typename T>
+	void retire(T&& resource) const {
+		auto values = std::array{ submittedValue(vk::QueueFlagBits::eGraphics), submittedValue(vk::QueueFlagBits::eTransfer) };
+		auto holder = std::make_shared<std::decay_t<T>>(std::forward<T>(resource));
+
+		std::scoped_lock lock(this->retireMutex);
+		this->retiredResources.push_back({ values, std::move(holder) });
+	};
+
+	// Frees the retired resources the GPU is done with, returns how many are still pending
+	std::size_t collectRetired() const;
 
-	[[nodiscard]] vk::Result submit(const vk::QueueFlagBits& family, const vk::SubmitInfo& si, const vk::Fence& fence) const noexcept;
-	void waitFence(const vk::Fence& fence) const noexcept;
-	void resetFence(const vk::Fence& fence) const noexcept;
 	void waitQueueIdle(const vk::QueueFlagBits& family) const noexcept;
 	void waitDeviceIdle() const noexcept;
 
 	void copy(vk_buffer& bufferDst, const void* bufferSrc, vk::DeviceSize offsetDst, vk::DeviceSize offsetSrc, vk::DeviceSize size) const;
 	void copy(void* bufferDst, const vk_buffer& bufferSrc, vk::DeviceSize offsetDst, vk::DeviceSize offsetSrc, vk::DeviceSize size) const;
-	void copy(vk_buffer& bufferDst, const vk_buffer& bufferSrc, vk::DeviceSize offsetDst, vk::DeviceSize offsetSrc, vk::DeviceSize size) const;
 
 private:
 	[[nodiscard]] inline bool separateQueues() const noexcept { return this->transferFamilyIndex != this->graphicsFamilyIndex; };
-	[[nodiscard]] std::optional<std::uint32_t> findMemoryType(std::uint32_t typeFilter, const vk::MemoryPropertyFlags& properties) const noexcept;
+	[[nodiscard]] inline bool sharedQueue() const noexcept { return this->transferQueue == this->graphicsQueue; };
+	[[nodiscard]] std::uint32_t familyIndex(const vk::QueueFlagBits& family) const noexcept;
+	[[nodiscard]] queue_timeline& timeline(const vk::QueueFlagBits& family) const noexcept { return this->timelines[family == vk::QueueFlagBits::eTransfer ? 1 : 0]; };
+	[[nodiscard]] const vk::Queue& queue(const vk::QueueFlagBits& family) const noexcept { return family == vk::QueueFlagBits::eTransfer ? this->transferQueue : this->graphicsQueue; };
+	[[nodiscard]] std::uint32_t memoryType(std::uint32_t typeFilter, memory_usage memoryUsage) const;
 	void createInstance(vk::ApplicationInfo& ai) noexcept;
 	void selectPhysicalDevice() noexcept;
 	void createLogicalDevice() noexcept;
+	void loadPipelineCache();
+	void savePipelineCache() const;
 	[[nodiscard]] vk::Result present(const vk::PresentInfoKHR& pi) const;
-	void executeOnQueue(const vk::QueueFlagBits& family, const std::function<void(const vk::CommandBuffer&)>& lambda) const;
 
 };
 
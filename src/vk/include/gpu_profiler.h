@@ -0,0 +1,52 @@
+#ifndef DISPLAY_GPU_PROFILER_H
+#define DISPLAY_GPU_PROFILER_H
+
+#include "engine_vk.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Timestamp query scopes feeding profiler's GPU track, one query range per slot (e.g. per cached command buffer)
+class gpu_profiler {
+public:
+	constexpr static std::uint32_t MAX_SCOPES = 8;
+
+private:
+	const engine_vk& engine;
+
+	vk::UniqueQueryPool queryPool;
+	std::size_t slots;
+
+	double nsPerTick;
+	std::uint64_t validMask;
+
+	// Scope names in the order they were recorded into each slot
+	std::vector<std::vector<std::string>> scopeNames;
+
+	// GPU timestamps live in their own clock domain, aligned once to the profiler's CPU epoch on first collection
+	std::optional<double> offsetUs;
+
+public:
+	gpu_profiler(const engine_vk& engine, std::size_t slots);
+
+	[[nodiscard]] bool isSupported() const noexcept { return this->validMask != 0; };
+
+	// Query pool must not be in use
+	void resize(std::size_t slots);
+
+	// Recorded at the start of the slot's command buffer, outside of any render pass
+	void reset(const vk::CommandBuffer& buffer, std::size_t slot);
+	[[nodiscard]] std::uint32_t begin(const vk::CommandBuffer& buffer, std::size_t slot, std::string_view name, vk::PipelineStageFlagBits stage = vk::PipelineStageFlagBits::eTopOfPipe);
+	void end(const vk::CommandBuffer& buffer, std::size_t slot, std::uint32_t scope, vk::PipelineStageFlagBits stage = vk::PipelineStageFlagBits::eBottomOfPipe) const;
+
+	// Call once per submission of the slot after it completed, results that aren't available are dropped
+	void collect(std::size_t slot);
+
+private:
+	void createQueryPool();
+	[[nodiscard]] std::uint32_t firstQuery(std::size_t slot) const noexcept { return static_cast<std::uint32_t>(slot) * gpu_profiler::MAX_SCOPES * 2; };
+};
+
+#endif //DISPLAY_GPU_PROFILER_H
@@ -0,0 +1,103 @@
+#ifndef DISPLAY_MEMORY_ALLOCATOR_H
+#define DISPLAY_MEMORY_ALLOCATOR_H
+
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+class memory_allocator {
+private:
+	struct block;
+
+public:
+	constexpr static vk::DeviceSize BLOCK_SIZE = 64 * 1024 * 1024;
+
+	struct statistics {
+		std::size_t blockCount = 0;
+		std::size_t allocationCount = 0;
+		std::size_t freeRangeCount = 0;
+		vk::DeviceSize bytesReserved = 0;
+		vk::DeviceSize bytesUsed = 0;
+		vk::DeviceSize bytesFree = 0;
+		vk::DeviceSize largestFreeRange = 0;
+
+		// 0 when all free space is one contiguous range, approaching 1 as it gets scattered
+		[[nodiscard]] float fragmentation() const noexcept {
+			return this->bytesFree == 0 ? 0.0f : 1.0f - static_cast<float>(this->largestFreeRange) / static_cast<float>(this->bytesFree);
+		};
+	};
+
+	class allocation {
+		friend class memory_allocator;
+	private:
+		memory_allocator* allocator = nullptr;
+		block* owner = nullptr;
+		vk::DeviceMemory memory{};
+		std::uint32_t memoryType = 0;
+		vk::DeviceSize offset = 0;
+		vk::DeviceSize size = 0;
+		void* mapped = nullptr;
+
+	public:
+		allocation() = default;
+		allocation(const allocation&) = delete;
+		allocation& operator=(const allocation&) = delete;
+		allocation(allocation&& other) noexcept { *this = std::move(other); };
+		allocation& operator=(allocation&& other) noexcept;
+		~allocation() { reset(); };
+
+		void reset() noexcept;
+
+		[[nodiscard]] const vk::DeviceMemory& getMemory() const noexcept { return this->memory; };
+		[[nodiscard]] std::uint32_t getMemoryType() const noexcept { return this->memoryType; };
+		[[nodiscard]] vk::DeviceSize getOffset() const noexcept { return this->offset; };
+		[[nodiscard]] vk::DeviceSize getSize() const noexcept { return this->size; };
+		explicit operator bool() const noexcept { return this->allocator != nullptr; };
+
+		// Host visible allocations stay mapped for their whole lifetime, nullptr otherwise
+		[[nodiscard]] void* getMapped() const noexcept { return this->mapped; };
+		[[nodiscard]] bool isCoherent() const noexcept;
+
+		// Ranges are relative to the allocation, both are no-ops on coherent memory
+		void flush(vk::DeviceSize rangeOffset = 0, vk::DeviceSize rangeSize = VK_WHOLE_SIZE) const;
+		void invalidate(vk::DeviceSize rangeOffset = 0, vk::DeviceSize rangeSize = VK_WHOLE_SIZE) const;
+	};
+
+private:
+	struct block {
+		vk::UniqueDeviceMemory memory;
+		vk::DeviceSize size;
+		std::map<vk::DeviceSize, vk::DeviceSize> freeRanges{}; // offset -> size, always coalesced
+		std::size_t allocations = 0;
+		void* mapped = nullptr; // Freeing the memory implicitly unmaps it
+	};
+
+	vk::Device device;
+	vk::PhysicalDeviceMemoryProperties memoryProperties;
+	vk::DeviceSize nonCoherentAtomSize;
+	vk::DeviceSize blockSize;
+
+	mutable std::mutex mutex;
+	std::array<std::vector<std::unique_ptr<block>>, VK_MAX_MEMORY_TYPES> blocks{};
+
+public:
+	memory_allocator(const vk::Device& device, const vk::PhysicalDeviceMemoryProperties& memoryProperties, vk::DeviceSize nonCoherentAtomSize, vk::DeviceSize blockSize = BLOCK_SIZE);
+
+	[[nodiscard]] allocation allocate(const vk::MemoryRequirements& requirements, std::uint32_t memoryType);
+	[[nodiscard]] statistics getStatistics() const;
+	void logStatistics() const;
+
+private:
+	void free(allocation& alloc) noexcept;
+	[[nodiscard]] bool isHostVisible(std::uint32_t memoryType) const noexcept;
+	[[nodiscard]] bool isCoherent(std::uint32_t memoryType) const noexcept;
+	[[nodiscard]] vk::MappedMemoryRange mappedRange(const allocation& alloc, vk::DeviceSize rangeOffset, vk::DeviceSize rangeSize) const noexcept;
+	[[nodiscard]] static std::optional<vk::DeviceSize> carve(block& b, const vk::MemoryRequirements& requirements) noexcept;
+};
+
+#endif //DISPLAY_MEMORY_ALLOCATOR_H
@@ -0,0 +1,52 @@
+#ifndef DISPLAY_OFFSCREEN_TARGET_H
+#define DISPLAY_OFFSCREEN_TARGET_H
+
+#include "render_target.h"
+
+class offscreen_target : public render_target {
+public:
+	// Readback assumes 32 bit color formats such as RGBA8 or BGRA8
+	constexpr static std::size_t BYTES_PER_TEXEL = 4;
+
+private:
+	const engine_vk& engine;
+
+	vk::Format format;
+	vk::Extent2D extent;
+
+	std::vector<engine_vk::vk_image> images{};
+	std::vector<engine_vk::vk_buffer> readbackBuffers{};
+	std::vector<vk::UniqueCommandBuffer> readbackCmdBuffers{};
+	std::vector<std::uint64_t> readbackValues{}; // Graphics timeline value of each image's last readback
+
+	std::uint32_t nextImage = 0;
+	std::optional<std::uint32_t> lastPresented{};
+
+public:
+	offscreen_target(const engine_vk& engine, const vk::Extent2D& extent, vk::Format format = vk::Format::eR8G8B8A8Unorm, std::size_t imageCount = render_target::SWAPCHAIN_IMAGES);
+
+	[[nodiscard]] vk::Format getFormat() const noexcept override { return this->format; };
+	[[nodiscard]] const vk::Extent2D& getExtent() const noexcept override { return this->extent; };
+	[[nodiscard]] std::size_t getNumImages() const noexcept override { return this->images.size(); };
+	[[nodiscard]] vk::Image getImage(std::size_t index) const noexcept override { return this->images[index].image.get(); };
+	[[nodiscard]] vk::ImageView getImageView(std::size_t index) const noexcept override { return this->images[index].view.get(); };
+	[[nodiscard]] vk::ImageLayout getFinalLayout() const noexcept override { return vk::ImageLayout::eTransferSrcOptimal; };
+	[[nodiscard]] std::uint32_t acquireNextImage(const vk::Semaphore& semaphore) override;
+	vk::Result present(const std::vector<vk::Semaphore>& waitSemaphores, std::uint32_t index) override;
+	void recreate() override;
+
+	// Takes effect on the next recreate, like a window resize does for a swapchain
+	void resize(const vk::Extent2D& newExtent) noexcept { this->extent = newExtent; };
+
+	[[nodiscard]] std::optional<std::uint32_t> getLastPresented() const noexcept { return this->lastPresented; };
+
+	// Tightly packed texels of the image's last presented frame, waits for its copy to finish
+	[[nodiscard]] std::vector<std::uint8_t> readback(std::uint32_t index) const;
+
+private:
+	void createImages(std::size_t imageCount);
+	[[nodiscard]] std::size_t imageBytes() const noexcept;
+	void recordReadback(std::size_t index);
+};
+
+#endif //DISPLAY_OFFSCREEN_TARGET_H
@@ -0,0 +1,35 @@
+#ifndef DISPLAY_PARALLEL_RECORDER_H
+#define DISPLAY_PARALLEL_RECORDER_H
+
+#include "engine_vk.h"
+
+#include <job_system.h>
+
+class parallel_recorder {
+public:
+	using record_function = std::function<void(const vk::CommandBuffer& buffer, std::size_t begin, std::size_t end)>;
+
+private:
+	struct worker_pool {
+		vk::UniqueCommandPool pool;
+		std::vector<vk::UniqueCommandBuffer> buffers{};
+		std::size_t used = 0;
+	};
+
+	const engine_vk& engine;
+	job_system& jobs;
+
+	// [frame slot][worker], a pool is only ever touched by its own worker thread
+	std::vector<std::vector<worker_pool>> pools{};
+
+public:
+	parallel_recorder(const engine_vk& engine, job_system& jobs, std::size_t frameSlots);
+
+	// Recycles every buffer recorded for the slot, the GPU must be done with the frame that last used it
+	void beginFrame(std::size_t frameSlot);
+
+	// Records the draw list as one secondary buffer per slice, returned in draw order for executeCommands
+	[[nodiscard]] std::vector<vk::CommandBuffer> record(std::size_t frameSlot, const vk::CommandBufferInheritanceInfo& cbii, std::size_t drawCount, const record_function& record);
+};
+
+#endif //DISPLAY_PARALLEL_RECORDER_H
@@ -1,23 +1,39 @@
 #ifndef DISPLAY_PIPELINE_H
 #define DISPLAY_PIPELINE_H
 
+#include "bindless_table.h"
 #include "engine_vk.h"
+#include "render_target.h"
 #include "renderpass.h"
-#include "swapchain.h"
+
+#include <functional>
+#include <future>
 
 class pipeline {
+private:
+	// Pipeline built from reloaded shader modules in the background, the current one is used until the swap
+	struct rebuild {
+		std::vector<std::shared_ptr<const shader_module_cache::shader>> modules{};
+		std::vector<vk::PipelineShaderStageCreateInfo> stages{};
+		std::future<vk::UniquePipeline> result{};
+	};
+
 protected:
 	const engine_vk& engine;
 
 	vk::UniquePipeline pipeLine;
 	vk::UniquePipelineLayout pipeLineLayout;
 
-	std::vector<std::tuple<vk::ShaderStageFlagBits, vk::UniqueShaderModule>> shaderModules{};
+	std::vector<std::tuple<vk::ShaderStageFlagBits, std::shared_ptr<const shader_module_cache::shader>>> shaderModules{}; // Shared through the engine's cache
 	std::vector<vk::PipelineShaderStageCreateInfo> shaderStages{};
-	vk::UniqueDescriptorSetLayout descriptorLayout;
+	std::vector<std::string> shaderNames{};
+	std::vector<vk::DescriptorSetLayoutBinding> descriptorBindings{};
+	vk::DescriptorSetLayout descriptorLayout{}; // Owned by the engine's layout cache
 	vk::UniqueDescriptorPool descriptorPool;
 	std::vector<vk::DescriptorSet> descriptorSets{};
 
+	std::vector<vk::VertexInputBindingDescription> vertexBindings{};
+	std::vector<vk::VertexInputAttributeDescription> vertexAttributes{};
 	vk::PipelineVertexInputStateCreateInfo pvisci{};
 	vk::PipelineInputAssemblyStateCreateInfo piasci{};
 	vk::PipelineTessellationStateCreateInfo ptsci{};
@@ -34,26 +50,71 @@ protected:
 
 	vk::PipelineDynamicStateCreateInfo pdsci{};
 
+	std::vector<vk::PushConstantRange> pushConstantRanges{};
+	vk::DescriptorSetLayout bindlessLayout{};
+	std::vector<vk::DescriptorSetLayout> setLayouts{};
 	vk::PipelineLayoutCreateInfo plci{};
 
+	std::vector<vk::Format> renderingFormats{};
+	vk::PipelineRenderingCreateInfoKHR prci{};
+
 	vk::GraphicsPipelineCreateInfo gpci{};
 
+private:
+	// Last member, a rebuild still running reads the create infos above when the pipeline is destroyed
+	std::unique_ptr<rebuild> pendingRebuild;
+
 public:
 	explicit pipeline(const engine_vk& engine);
 
 	void setViewPortScissor(const vk::Extent2D &size);
 	void setDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& descriptorSetLayoutBindings);
+	void addPushConstantRange(const vk::PushConstantRange& range);
+	// Puts the global table at set 0, the pipeline's own descriptor set layout moves to set 1
+	void useBindless(const bindless_table& table);
 
 	void createDescriptorSetPool(const std::vector<vk::DescriptorPoolSize>& poolSizes, std::uint32_t maxSets);
-
-	virtual void finalize(const renderpass& renderpass, const swapchain& swapchain);
+	// Pool sizes derived from the descriptor set layout, enough for maxSets sets
+	void createDescriptorSetPool(std::uint32_t maxSets);
+	[[nodiscard]] vk::UniqueDescriptorUpdateTemplate createUpdateTemplate(const std::vector<vk::DescriptorUpdateTemplateEntry>& entries) const;
+	[[nodiscard]] const vk::DescriptorSetLayout& getDescriptorLayout() const noexcept { return this->descriptorLayout; };
+
+	virtual void finalize(const renderpass& renderpass, const render_target& target);
+	// For passes built elsewhere, e.g. by render_graph
+	void finalize(const vk::RenderPass& renderPass, std::uint32_t subpass);
+	// For dynamic rendering, only the attachment formats have to match what the pipeline is used with
+	void finalize(const std::vector<vk::Format>& colorFormats, vk::Format depthFormat = vk::Format::eUndefined);
 	void bind(const vk::UniqueCommandBuffer& buffer, vk::PipelineBindPoint pipelineBindPoint);
+	void bind(const vk::CommandBuffer& buffer, vk::PipelineBindPoint pipelineBindPoint) const;
 	void bindDescriptorSets(const vk::UniqueCommandBuffer& buffer, vk::PipelineBindPoint pipelineBindPoint, std::uint32_t firstSet, std::uint32_t descriptorSetCount, const vk::DescriptorSet* pDescriptorSets, std::uint32_t dynamicOffsetCount, const std::uint32_t* pDynamicOffsets);
+	void bindDescriptorSets(const vk::CommandBuffer& buffer, vk::PipelineBindPoint pipelineBindPoint, std::uint32_t firstSet, std::uint32_t descriptorSetCount, const vk::DescriptorSet* pDescriptorSets) const;
+	void pushConstants(const vk::CommandBuffer& buffer, const vk::ShaderStageFlags& stages, std::uint32_t offset, std::uint32_t size, const void* data) const;
 	std::vector<vk::DescriptorSet> getSets(std::uint32_t descriptorCount);
 
+	[[nodiscard]] bool usesShader(const std::string& name) const noexcept;
+	// Reloads every shader file and builds the pipeline again on another thread, swapRebuilt installs it once done
+	void reloadShaders();
+	// Call at a frame boundary, true if the pipeline was replaced and recorded command buffers must be recorded again
+	[[nodiscard]] bool swapRebuilt();
+
 protected:
 	void addShader(const vk::ShaderStageFlagBits& type, const std::string &filename) noexcept;
 
+	// From the shaders' reflection: the pipeline's own descriptor set, after the bindless one if used, and one push
+	// constant range per stage, call after useBindless
+	void reflectLayout();
+	// Vertex stage inputs packed in location order into one per-vertex binding
+	void reflectVertexInput(std::uint32_t binding = 0);
+
+	// Builds pipeLineLayout from the descriptor set layout and push constant ranges, retiring the previous pipeline
+	void createLayout();
+	void createPipeline();
+	// Copies the create infos so that the returned function may run on another thread, stages must outlive it
+	[[nodiscard]] virtual std::function<vk::UniquePipeline()> builder(const std::vector<vk::PipelineShaderStageCreateInfo>& stages) const;
+
+	// Blocks until a pending rebuild is done, needed before the create infos it reads are changed
+	void finishRebuild();
+
 };
 
 #endif //DISPLAY_PIPELINE_H
@@ -0,0 +1,164 @@
+#ifndef DISPLAY_RENDER_GRAPH_H
+#define DISPLAY_RENDER_GRAPH_H
+
+#include "engine_vk.h"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+// Frame graph over named image resources: passes declare what they read and write, compile derives
+// the order, culls passes nothing consumes, places barriers and aliases transient attachments' memory
+class render_graph {
+public:
+	using resource_id = std::uint32_t;
+	using executor = std::function<void(const vk::CommandBuffer&)>;
+
+	// Owned by the graph, only alive between its first and last use within a frame
+	struct attachment_info {
+		vk::Format format;
+		vk::Extent2D extent;
+		vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor;
+	};
+
+	struct statistics {
+		std::size_t passes = 0;
+		std::size_t culledPasses = 0;
+		std::size_t barriers = 0;
+		vk::DeviceSize transientBytes = 0; // Memory actually allocated for transients
+		vk::DeviceSize unaliasedBytes = 0; // What they would need without aliasing
+	};
+
+private:
+	enum class attachment_kind {
+		none,
+		color,
+		depth
+	};
+
+	struct access {
+		std::string resource;
+		vk::ImageLayout layout;
+		vk::PipelineStageFlags stages;
+		vk::AccessFlags accessMask;
+		bool write;
+		attachment_kind attachment;
+		std::optional<vk::ClearValue> clear;
+	};
+
+public:
+	class pass {
+		friend class render_graph;
+	private:
+		std::string name;
+		bool graphics;
+		bool sideEffects = false;
+		std::vector<access> accesses{};
+		executor record{};
+
+		pass(std::string name, bool graphics) : name(std::move(name)), graphics(graphics) {};
+	public:
+		pass& writeColor(const std::string& resource, std::optional<vk::ClearColorValue> clear = {});
+		pass& writeDepth(const std::string& resource, std::optional<vk::ClearDepthStencilValue> clear = {});
+		pass& readDepth(const std::string& resource);
+		pass& sample(const std::string& resource, const vk::PipelineStageFlags& stages = vk::PipelineStageFlagBits::eFragmentShader);
+		pass& readStorage(const std::string& resource, const vk::PipelineStageFlags& stages = vk::PipelineStageFlagBits::eComputeShader);
+		pass& writeStorage(const std::string& resource, const vk::PipelineStageFlags& stages = vk::PipelineStageFlagBits::eComputeShader);
+
+		// Never culled, for passes whose results leave the graph some other way
+		pass& keep() noexcept { this->sideEffects = true; return *this; };
+		pass& execute(executor record) { this->record = std::move(record); return *this; };
+	};
+
+private:
+	struct resource {
+		std::string name;
+		attachment_info info;
+		bool imported;
+		bool output;
+
+		// Imported images keep their layouts at the graph's borders, transients start undefined every frame
+		vk::Image image{};
+		vk::ImageView view{};
+		vk::ImageLayout initialLayout = vk::ImageLayout::eUndefined;
+		vk::ImageLayout finalLayout = vk::ImageLayout::eUndefined;
+
+		vk::ImageUsageFlags usage{};
+		vk::UniqueImage ownedImage;
+		vk::UniqueImageView ownedView;
+		vk::MemoryRequirements requirements{};
+		std::optional<std::size_t> bucket{};
+		std::size_t firstUse = 0;
+		std::size_t lastUse = 0;
+	};
+
+	// Transients with disjoint lifetimes bound to the same memory
+	struct memory_bucket {
+		memory_allocator::allocation memory;
+		vk::MemoryRequirements requirements;
+		std::vector<resource_id> members{};
+	};
+
+	struct compiled_pass {
+		std::size_t passIndex;
+		std::vector<vk::ImageMemoryBarrier> barriers{};
+		std::vector<resource_id> barrierResources{}; // Imported images are patched in at execute
+		vk::PipelineStageFlags srcStages{};
+		vk::PipelineStageFlags dstStages{};
+
+		vk::UniqueRenderPass renderPass;
+		std::vector<resource_id> attachments{};
+		std::vector<vk::ClearValue> clearValues{};
+		std::map<std::vector<vk::ImageView>, vk::UniqueFramebuffer> frameBuffers{};
+	};
+
+	const engine_vk& engine;
+
+	std::vector<resource> resources{};
+	std::unordered_map<std::string, resource_id> resourceIds{};
+	std::deque<pass> passes{}; // Stable references for the builders handed out
+
+	std::vector<compiled_pass> compiled{};
+	std::vector<memory_bucket> buckets{};
+	std::vector<vk::ImageMemoryBarrier> finalBarriers{};
+	std::vector<resource_id> finalResources{};
+	vk::PipelineStageFlags finalSrcStages{};
+
+	statistics stats{};
+
+public:
+	explicit render_graph(const engine_vk& engine) : engine(engine) {};
+
+	void createAttachment(const std::string& name, const attachment_info& info);
+	void importImage(const std::string& name, const attachment_info& info, vk::ImageLayout initialLayout, vk::ImageLayout finalLayout);
+
+	// Imported images may change every frame, e.g. to the acquired swapchain image, without recompiling
+	void setImage(const std::string& name, const vk::Image& image, const vk::ImageView& view);
+
+	// Marks what the frame produces, passes not contributing to an output are culled
+	void markOutput(const std::string& name);
+
+	pass& addGraphicsPass(const std::string& name);
+	pass& addComputePass(const std::string& name);
+
+	// Rebuilds order, barriers, transient images and render passes, call again after resizing attachments
+	void compile();
+	void execute(const vk::CommandBuffer& buffer);
+
+	// Graphics pipelines of a pass are created against this, valid until the next compile, the pass must have survived culling
+	[[nodiscard]] vk::RenderPass getRenderPass(const std::string& passName) const;
+	[[nodiscard]] vk::ImageView getView(const std::string& name) const;
+	[[nodiscard]] const statistics& getStatistics() const noexcept { return this->stats; };
+
+private:
+	[[nodiscard]] resource_id find(const std::string& name) const;
+	[[nodiscard]] std::vector<bool> cullPasses() const;
+	[[nodiscard]] std::vector<std::size_t> sortPasses(const std::vector<bool>& alive) const;
+	void allocateTransients();
+	void computeBarriers(const std::vector<std::size_t>& order);
+	void createRenderPass(compiled_pass& target, const std::vector<std::size_t>& order, std::size_t position);
+	void retireCompiled();
+};
+
+#endif //DISPLAY_RENDER_GRAPH_H
@@ -0,0 +1,30 @@
+#ifndef DISPLAY_RENDER_TARGET_H
+#define DISPLAY_RENDER_TARGET_H
+
+#include "engine_vk.h"
+
+class render_target {
+public:
+	constexpr static std::size_t SWAPCHAIN_IMAGES = 3;
+	constexpr static std::size_t FRAMES_IN_FLIGHT = 4;
+
+	virtual ~render_target() = default;
+
+	[[nodiscard]] virtual vk::Format getFormat() const noexcept = 0;
+	[[nodiscard]] virtual const vk::Extent2D& getExtent() const noexcept = 0;
+	[[nodiscard]] virtual std::size_t getNumImages() const noexcept = 0;
+	[[nodiscard]] virtual vk::Image getImage(std::size_t index) const noexcept = 0;
+	[[nodiscard]] virtual vk::ImageView getImageView(std::size_t index) const noexcept = 0;
+
+	// Layout the render pass leaves the image in for whatever consumes it next
+	[[nodiscard]] virtual vk::ImageLayout getFinalLayout() const noexcept = 0;
+
+	// Signals the semaphore once the returned image may be rendered to
+	[[nodiscard]] virtual std::uint32_t acquireNextImage(const vk::Semaphore& semaphore) = 0;
+	virtual vk::Result present(const std::vector<vk::Semaphore>& waitSemaphores, std::uint32_t index) = 0;
+
+	// Rebuilds the images after the target went out of date, the format may change
+	virtual void recreate() = 0;
+};
+
+#endif //DISPLAY_RENDER_TARGET_H
@@ -1,31 +1,69 @@
 #ifndef DISPLAY_RENDERPASS_H
 #define DISPLAY_RENDERPASS_H
 
-#include "swapchain.h"
+#include "render_target.h"
 
 class renderpass {
 	friend class pipeline;
+public:
+	// Lives only within the pass: cleared on load, never stored, backed by lazily allocated memory where available
+	struct transient_attachment {
+		vk::Format format;
+		vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor;
+		vk::ClearValue clear{};
+	};
+
+	// Attachment 0 is the target image, transient attachments follow in the order they were given
+	struct subpass_info {
+		std::vector<std::uint32_t> colors;
+		std::vector<std::uint32_t> inputs{};
+		std::optional<std::uint32_t> depth{};
+	};
+
 private:
+	struct subpass_refs {
+		std::vector<vk::AttachmentReference> colors{};
+		std::vector<vk::AttachmentReference> inputs{};
+		std::optional<vk::AttachmentReference> depth{};
+	};
+
 	const engine_vk& engine;
-	const swapchain& swapChain;
+	const render_target& target;
 
 	std::vector<vk::AttachmentDescription> colorAttachements{};
-	std::vector<vk::AttachmentReference> colorAttachementRefs{};
 	std::vector<vk::AttachmentDescription> renderPassAttachements{};
 	std::vector<vk::SubpassDescription> subpasses{};
 	std::vector<vk::SubpassDependency> dependencies{};
 	vk::RenderPassCreateInfo rpci{};
 	vk::UniqueRenderPass renderPass;
 
+	std::vector<transient_attachment> transients{};
+	std::vector<vk::ImageUsageFlags> transientUsage{};
+	std::vector<subpass_refs> subpassRefs{};
+
+	// Indexed by target image like the framebuffers, frames in flight never share a G-buffer
+	std::vector<std::vector<engine_vk::vk_image>> transientImages{};
 	std::vector<vk::UniqueFramebuffer> frameBuffers{};
 
 public:
-	renderpass(const engine_vk& engine, const class swapchain& swapchain);
-	void updateFormat() noexcept;
+	renderpass(const engine_vk& engine, const render_target& target);
+	// Chained subpasses reading earlier results as input attachments, dependencies between them are by region
+	renderpass(const engine_vk& engine, const render_target& target, std::vector<transient_attachment> transientAttachments, const std::vector<subpass_info>& subpassInfos);
+
+	[[nodiscard]] bool updateFormat() noexcept;
+	void createPass();
+	void createFrameBuffers();
 	void createPassAndFrameBuffers();
 
+	[[nodiscard]] vk::RenderPass getRenderPass() const noexcept { return this->renderPass.get(); };
+	[[nodiscard]] std::uint32_t getSubpassCount() const noexcept { return static_cast<std::uint32_t>(this->subpasses.size()); };
+
+	// Missing clear values of transient attachments are taken from their description
 	void begin(const vk::UniqueCommandBuffer& buffer, std::size_t index, const vk::Rect2D& renderArea, const std::vector<vk::ClearValue>& clearValues, vk::SubpassContents contents);
-	void inherit(vk::CommandBufferInheritanceInfo& cbii, bool includeFramebuffer = true);
+	void inherit(vk::CommandBufferInheritanceInfo& cbii, std::optional<std::size_t> frameBufferIndex = {}, std::uint32_t subpass = 0) const noexcept;
+
+private:
+	void describe(const std::vector<subpass_info>& subpassInfos);
 
 };
 
@@ -0,0 +1,42 @@
+#ifndef DISPLAY_SHADER_MODULE_CACHE_H
+#define DISPLAY_SHADER_MODULE_CACHE_H
+
+#include "spirv_reflection.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Shader modules keyed by the hash of their SPIR-V, pipelines loading the same code share one module and its
+// reflection, and each file is only read the first time its name is asked for
+class shader_module_cache {
+public:
+	struct shader {
+		std::vector<std::uint32_t> code;
+		vk::UniqueShaderModule module;
+		spirv_reflection reflection;
+	};
+
+private:
+	vk::Device device;
+
+	std::unordered_map<std::size_t, std::shared_ptr<const shader>> byHash{};
+	std::unordered_map<std::string, std::shared_ptr<const shader>> byName{};
+	mutable std::mutex mutex;
+
+public:
+	explicit shader_module_cache(const vk::Device& device) : device(device) {};
+
+	// Name as passed to app_com::loadShader, a shader that can't be loaded or reflected is fatal
+	[[nodiscard]] std::shared_ptr<const shader> get(const std::string& name);
+	// Reads the file of a shader loaded before again, e.g. after it was recompiled, unchanged or broken code
+	// returns the module already cached and modules nothing else references anymore are dropped
+	[[nodiscard]] std::shared_ptr<const shader> reload(const std::string& name);
+	[[nodiscard]] std::size_t size() const;
+
+private:
+	std::shared_ptr<const shader> load(const std::string& name);
+};
+
+#endif //DISPLAY_SHADER_MODULE_CACHE_H
@@ -0,0 +1,44 @@
+#ifndef DISPLAY_SHADER_RELOADER_H
+#define DISPLAY_SHADER_RELOADER_H
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches the GLSL sources and recompiles edited ones on a background thread, the SPIR-V replaces what
+// app_com::loadShader reads so that pipelines pick it up on their next reloadShaders
+// Only does something when built with DISPLAY_HOT_RELOAD
+class shader_reloader {
+public:
+	constexpr static int POLL_TIMEOUT_MS = 100;
+
+private:
+	std::filesystem::path sourceDir;
+	std::filesystem::path outputDir;
+
+	int inotify = -1;
+	std::atomic<bool> running = false;
+	std::thread watcher;
+
+	// Shader names as passed to loadShader, compiled since the last poll
+	std::vector<std::string> compiled{};
+	std::mutex mutex;
+
+public:
+	explicit shader_reloader(std::filesystem::path sourceDir, std::filesystem::path outputDir = "shaders");
+	~shader_reloader();
+
+	shader_reloader(const shader_reloader&) = delete;
+	shader_reloader& operator=(const shader_reloader&) = delete;
+
+	[[nodiscard]] std::vector<std::string> poll();
+
+private:
+	void watch();
+	bool compile(const std::filesystem::path& source);
+};
+
+#endif //DISPLAY_SHADER_RELOADER_H
@@ -0,0 +1,51 @@
+#ifndef DISPLAY_SPIRV_REFLECTION_H
+#define DISPLAY_SPIRV_REFLECTION_H
+
+#include <vulkan/vulkan.hpp>
+#include <optional>
+#include <span>
+#include <vector>
+
+// Interface of a single entry point module read straight from its SPIR-V, enough to derive descriptor set
+// layouts, push constant ranges and vertex input without repeating them by hand
+class spirv_reflection {
+public:
+	struct descriptor_binding {
+		std::uint32_t set;
+		std::uint32_t binding;
+		vk::DescriptorType type;
+		std::uint32_t count; // 0 for runtime sized arrays
+
+		bool operator==(const descriptor_binding& other) const noexcept = default;
+	};
+
+	struct vertex_input {
+		std::uint32_t location;
+		vk::Format format;
+		std::uint32_t size;
+
+		bool operator==(const vertex_input& other) const noexcept = default;
+	};
+
+private:
+	vk::ShaderStageFlagBits stage = vk::ShaderStageFlagBits::eAll;
+	std::vector<descriptor_binding> bindings{};
+	std::optional<vk::PushConstantRange> pushConstants{};
+	std::vector<vertex_input> inputs{};
+
+public:
+	// Throws std::runtime_error on modules it can't reflect, shader_module_cache decides whether that is fatal
+	explicit spirv_reflection(std::span<const std::uint32_t> code);
+
+	[[nodiscard]] vk::ShaderStageFlagBits getStage() const noexcept { return this->stage; };
+	// Sorted by set and binding
+	[[nodiscard]] const std::vector<descriptor_binding>& getBindings() const noexcept { return this->bindings; };
+	[[nodiscard]] const std::optional<vk::PushConstantRange>& getPushConstants() const noexcept { return this->pushConstants; };
+	// Vertex stage only, sorted by location, matrices take one location per column
+	[[nodiscard]] const std::vector<vertex_input>& getInputs() const noexcept { return this->inputs; };
+
+	// Whether a module can replace this one without a new pipeline layout or vertex input
+	[[nodiscard]] bool sameInterface(const spirv_reflection& other) const noexcept;
+};
+
+#endif //DISPLAY_SPIRV_REFLECTION_H
@@ -0,0 +1,62 @@
+#ifndef DISPLAY_STAGING_UPLOADER_H
+#define DISPLAY_STAGING_UPLOADER_H
+
+#include "engine_vk.h"
+
+#include <deque>
+#include <mutex>
+
+class staging_uploader {
+	friend class upload_ticket;
+public:
+	constexpr static vk::DeviceSize RING_SIZE = 32 * 1024 * 1024;
+	constexpr static vk::DeviceSize RING_ALIGNMENT = 16;
+
+	using ticket = upload_ticket;
+
+private:
+	// Complete once the graphics queue owns the uploaded ranges, i.e. the timeline value of the batch's last submit
+	struct batch {
+		std::uint64_t id;
+		vk::UniqueCommandBuffer cmdBuffer;
+		vk::UniqueCommandBuffer acquireCmdBuffer;
+		vk::QueueFlagBits family;
+		std::uint64_t value;
+		std::uint64_t ringEnd;
+	};
+
+	const engine_vk& engine;
+
+	engine_vk::vk_buffer ring;
+
+	// Monotonic byte counters, ring offset is counter % RING_SIZE
+	std::uint64_t head = 0;
+	std::uint64_t tail = 0;
+
+	vk::UniqueCommandBuffer recording;
+	std::uint64_t recordingBatch = 1;
+
+	// Ranges of the recording batch changing queue family ownership from transfer to graphics
+	std::vector<vk::BufferMemoryBarrier> ownershipTransfers{};
+
+	std::deque<batch> inFlight{};
+	std::uint64_t completedBatch = 0;
+
+	std::recursive_mutex mutex;
+
+public:
+	explicit staging_uploader(const engine_vk& engine);
+
+	ticket upload(const engine_vk::vk_buffer& dst, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size);
+	ticket flush();
+	void collect();
+
+private:
+	vk::DeviceSize reserve(vk::DeviceSize size);
+	void retireOldest();
+	[[nodiscard]] vk::UniqueCommandBuffer recordAcquire() const;
+	[[nodiscard]] bool isComplete(std::uint64_t batchId);
+	void waitFor(std::uint64_t batchId);
+};
+
+#endif //DISPLAY_STAGING_UPLOADER_H
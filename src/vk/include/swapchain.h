@@ -1,18 +1,12 @@
 #ifndef DISPLAY_SWAPCHAIN_H
 #define DISPLAY_SWAPCHAIN_H
 
-#include "engine_vk.h"
+#include "render_target.h"
 
-class swapchain {
-	friend class renderpass;
-public:
-	constexpr static std::size_t SWAPCHAIN_IMAGES = 3;
-	constexpr static std::size_t FRAMES_IN_FLIGHT = 4;
+class swapchain : public render_target {
 private:
 	const engine_vk& engine;
 
-	std::array<std::uint32_t, 2> queueFamilyIndices;
-
 	vk::SurfaceFormatKHR format;
 	vk::PresentModeKHR presentMode;
 	vk::Extent2D extent;
@@ -25,10 +19,15 @@ private:
 public:
 	explicit swapchain(const engine_vk& engine);
 	void createSwapChain();
-	[[nodiscard]] const vk::Extent2D& getExtent() const noexcept { return this->extent; };
-	[[nodiscard]] std::size_t getNumImages() const noexcept { return this->swapChainImages.size(); };
-	[[nodiscard]] std::uint32_t acquireNextImage(const vk::Semaphore& semaphore) const;
-	vk::Result present(const std::vector<vk::Semaphore>& waitSemaphores, std::uint32_t index) const;
+	[[nodiscard]] vk::Format getFormat() const noexcept override { return this->format.format; };
+	[[nodiscard]] const vk::Extent2D& getExtent() const noexcept override { return this->extent; };
+	[[nodiscard]] std::size_t getNumImages() const noexcept override { return this->swapChainImages.size(); };
+	[[nodiscard]] vk::Image getImage(std::size_t index) const noexcept override { return this->swapChainImages[index]; };
+	[[nodiscard]] vk::ImageView getImageView(std::size_t index) const noexcept override { return this->swapChainImageViews[index].get(); };
+	[[nodiscard]] vk::ImageLayout getFinalLayout() const noexcept override { return vk::ImageLayout::ePresentSrcKHR; };
+	[[nodiscard]] std::uint32_t acquireNextImage(const vk::Semaphore& semaphore) override;
+	vk::Result present(const std::vector<vk::Semaphore>& waitSemaphores, std::uint32_t index) override;
+	void recreate() override { createSwapChain(); };
 };
 
 
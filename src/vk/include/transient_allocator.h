@@ -0,0 +1,47 @@
+#ifndef DISPLAY_TRANSIENT_ALLOCATOR_H
+#define DISPLAY_TRANSIENT_ALLOCATOR_H
+
+#include "engine_vk.h"
+
+#include <optional>
+
+// Linear per-frame allocator for streamed constants and dynamic vertex data, carved from one persistently mapped buffer
+class transient_allocator {
+public:
+	constexpr static vk::DeviceSize DEFAULT_FRAME_SIZE = 4 * 1024 * 1024;
+
+	struct allocation {
+		vk::Buffer buffer;
+		vk::DeviceSize offset;
+		vk::DeviceSize size;
+		void* data;
+	};
+
+private:
+	const engine_vk& engine;
+
+	engine_vk::vk_buffer buffer;
+	vk::DeviceSize frameSize;
+	vk::DeviceSize defaultAlignment;
+
+	std::size_t frame = 0;
+	vk::DeviceSize head = 0;
+
+public:
+	transient_allocator(const engine_vk& engine, std::size_t frames, vk::DeviceSize frameSize = DEFAULT_FRAME_SIZE,
+						const vk::BufferUsageFlags& usage = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer);
+
+	// Recycles the slot's region, the GPU must be done with the last frame that used it
+	void beginFrame(std::size_t frameSlot) noexcept;
+
+	// Empty once the frame's region is exhausted, defaults to minUniformBufferOffsetAlignment
+	[[nodiscard]] std::optional<allocation> allocate(vk::DeviceSize size, std::optional<vk::DeviceSize> alignment = {}) noexcept;
+
+	// Makes this frame's writes visible on non-coherent memory, call before submitting
+	void flush() const;
+
+	[[nodiscard]] vk::DeviceSize getUsed() const noexcept { return this->head; };
+	[[nodiscard]] vk::DeviceSize getFrameSize() const noexcept { return this->frameSize; };
+};
+
+#endif //DISPLAY_TRANSIENT_ALLOCATOR_H
@@ -1,79 +1,208 @@
 #ifndef DISPLAY_TRIANGLE_RENDERER_H
 
-#include "swapchain.h"
+#include "bindless_table.h"
+#include "command_cache.h"
+#include "compute_pipeline.h"
+#include "dynamic_rendering.h"
+#include "gpu_profiler.h"
+#include "parallel_recorder.h"
 #include "pipeline.h"
+#include "render_target.h"
 #include "renderpass.h"
+#include "shader_reloader.h"
+#include "staging_uploader.h"
 
+#include <chrono>
+#include <culling.h>
+#include <optional>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
 class triangle_pipeline : public pipeline {
 public:
+    // Vertex input is reflected from the shader, the members follow its input locations in order
     class triangle_vertex {
         glm::vec3 pos;
 
     public:
         explicit triangle_vertex(const glm::vec3& pos): pos(pos) {};
+    };
+private:
+    std::vector<vk::DynamicState> dynamicStates{};
 
-        static constexpr auto bindingDescriptions() {
-            std::array<vk::VertexInputBindingDescription, 1> vibd {};
-
-            vibd[0].binding = 0;
-            vibd[0].stride = sizeof(triangle_vertex);
-            vibd[0].inputRate = vk::VertexInputRate::eVertex;
-
-            return vibd;
-        };
-
-        static constexpr auto attributeDescriptions() {
-            std::array<vk::VertexInputAttributeDescription, 1> viad {};
+public:
+    explicit triangle_pipeline(const engine_vk& engine, const std::string& vertexShader = "passthrough");
+};
 
-            viad[0].binding = 0;
-            viad[0].location = 0;
-            viad[0].format = vk::Format::eR32G32B32Sfloat;
-            viad[0].offset = 0; //offsetof(triangle_vertex, pos)
+// Same vertex layout, the vertex shader reads each instance's transform from a storage buffer at set 0 binding 0
+// With a bindless table that buffer is picked from the global set by the index in the push constant instead,
+// either way the layout is reflected from the shader
+class instanced_pipeline : public triangle_pipeline {
+public:
+    explicit instanced_pipeline(const engine_vk& engine);
+};
 
-            return viad;
-        }
+// Frustum culls instances and writes their indirect draw commands, compacted behind a GPU draw count when supported
+class cull_pipeline : public compute_pipeline {
+public:
+    static constexpr std::uint32_t GROUP_SIZE = 64;
+
+    // Mirrors the push constant block of cull.comp
+    struct constants {
+        std::array<glm::vec4, 6> planes;
+        glm::vec4 bounds;
+        std::uint32_t instanceCount;
+        std::uint32_t indexCount;
+        std::uint32_t compact;
+    };
 
+    // Instances, commands and draw count, laid out for the update template
+    struct buffers {
+        vk::DescriptorBufferInfo instances;
+        vk::DescriptorBufferInfo commands;
+        vk::DescriptorBufferInfo count;
     };
+
 private:
-    std::vector<vk::DynamicState> dynamicStates{};
-    std::vector<vk::VertexInputBindingDescription> bindingDescription{};
-    std::vector<vk::VertexInputAttributeDescription> attributeDescription{};
+    vk::UniqueDescriptorUpdateTemplate updateTemplate;
 
 public:
-    explicit triangle_pipeline(const engine_vk& engine);
+    explicit cull_pipeline(const engine_vk& engine);
+
+    void write(const vk::DescriptorSet& set, const buffers& bound) const noexcept;
 };
 
 class triangle_renderer {
     static constexpr std::size_t vertex_count = 3;
+    static constexpr std::size_t scene_chunks = 1;
+    static constexpr std::array<std::uint16_t, vertex_count> indices { 0, 1, 2 };
+public:
+    static constexpr float bounding_radius = 0.70710678f; // Sphere around the origin enclosing the vertices
+
+    struct frame_timing {
+        static constexpr std::size_t REPORT_INTERVAL = 1000;
+
+        std::size_t frames = 0;
+        std::chrono::steady_clock::duration total{};
+        std::chrono::steady_clock::duration waited{};
+
+        void add(std::chrono::steady_clock::duration frame, std::chrono::steady_clock::duration wait) noexcept {
+            ++this->frames;
+            this->total += frame;
+            this->waited += wait;
+        };
+
+        [[nodiscard]] double averageFrameMs() const noexcept {
+            return this->frames == 0 ? 0.0 : std::chrono::duration<double, std::milli>(this->total).count() / static_cast<double>(this->frames);
+        };
+
+        [[nodiscard]] double averageWaitMs() const noexcept {
+            return this->frames == 0 ? 0.0 : std::chrono::duration<double, std::milli>(this->waited).count() / static_cast<double>(this->frames);
+        };
+
+        // Share of CPU frame time not spent blocked on fences, says nothing about how much GPU work ran meanwhile
+        [[nodiscard]] double unblockedShare() const noexcept {
+            return this->total.count() == 0 ? 0.0 : 1.0 - static_cast<double>(this->waited.count()) / static_cast<double>(this->total.count());
+        };
+    };
+
 private:
     const engine_vk& engine;
+    std::size_t drawCount;
     triangle_pipeline trianglePipeline;
-    swapchain swapChain;
+    instanced_pipeline instancedPipeline;
+    cull_pipeline cullPipeline;
+    std::unique_ptr<render_target> target;
     renderpass renderPass;
 
+    // Set by setDynamicRendering, frames then render through dynamicPass and renderPass' framebuffers go stale
+    bool dynamicRendering = false;
+    dynamic_rendering dynamicPass;
+
+    // Primaries are keyed by target image since they bind its framebuffer, static scene chunks are shared secondaries
+    command_cache primaryCmdBuffers;
+    command_cache sceneCmdBuffers;
+
+    // Set when recording on a job system, the draw list is then re-recorded every frame across its workers
+    std::unique_ptr<parallel_recorder> recorder;
+
     engine_vk::vk_buffer vertexBuffer;
+    engine_vk::vk_buffer indexBuffer;
+
+    // Set by setInstances, the whole scene is then drawn by the commands in indirectBuffer
+    bool indirect = false;
+    std::uint32_t instanceCount = 0;
+    std::uint32_t indirectCommands = 0;
     engine_vk::vk_buffer ssboBuffer;
-    std::vector<engine_vk::vk_buffer> uniformBuffers;
-    std::vector<vk::DescriptorSet> descriptorSets;
+    engine_vk::vk_buffer indirectBuffer;
+    engine_vk::vk_buffer countBuffer;
+    vk::DescriptorSet instanceSet;
+
+    // Slot of ssboBuffer in the engine's bindless table, used instead of instanceSet when the device supports it
+    std::optional<bindless_table::index> transformSlot;
+
+    // Set by setInstances with culling, the commands are then rewritten on the GPU ahead of every render pass
+    bool culling = false;
+    cull_pipeline::constants cullConstants{};
+    vk::DescriptorSet cullSet;
+
+    // Set by setVisibleInstances, the listed instances are then drawn through commands written on the CPU
+    bool cpuCulling = false;
+    std::vector<std::uint32_t> visibleInstances{};
 
-    std::vector<vk::UniqueCommandBuffer> cmdBuffers;
+    // Indexed by frame slot, host visible so that each frame writes its own list
+    std::vector<engine_vk::vk_buffer> visibleCommands;
+    std::vector<std::uint32_t> visibleCounts;
+
+    // Indexed by frame slot (currentFrame), never by target image
     std::vector<vk::UniqueSemaphore> imageAvailableSemaphores;
     std::vector<vk::UniqueSemaphore> renderFinishedSemaphores;
-    std::vector<vk::UniqueFence> inFlightFences;
-    std::vector<vk::Fence> imagesInFlight;
+    std::vector<std::uint64_t> frameValues;
+
+    // Indexed by target image, graphics timeline value of the last submission rendering to it
+    std::vector<std::uint64_t> imageValues;
 
     std::uint32_t nextImage;
     std::size_t currentFrame;
 
-    void allocateCmdBuffers();
+    frame_timing timing{};
+
+    // Only created when built with DISPLAY_PROFILING, timestamp slots are keyed by target image like the primaries
+    std::unique_ptr<gpu_profiler> gpuProfiler;
+
+    // Only created when built with DISPLAY_HOT_RELOAD, rebuilt pipelines are swapped in at startFrame
+    std::unique_ptr<shader_reloader> shaderReloader;
+
     void allocateVertexBuffer();
-    void recordCmdBuffer(std::uint32_t index) noexcept;
+    void recordPrimary(std::uint32_t image, const vk::UniqueCommandBuffer& buffer);
+    void recordSceneChunk(std::size_t chunk, const vk::UniqueCommandBuffer& buffer);
+    void recordDraws(const vk::CommandBuffer& buffer, std::size_t begin, std::size_t end) const;
+    void recordIndirect(const vk::CommandBuffer& buffer) const;
+    void recordCulling(const vk::CommandBuffer& buffer) const;
+    void writeVisibleCommands(std::size_t frame);
+    void waitAllFrames() noexcept;
+    void finalizePipelines();
+    void reloadShaders();
 
 public:
-    explicit triangle_renderer(const engine_vk& engine);
+    triangle_renderer(const engine_vk& engine, std::unique_ptr<render_target> target, job_system* jobs = nullptr, std::size_t drawCount = 1);
+    ~triangle_renderer();
+    [[nodiscard]] render_target& getTarget() const noexcept { return *this->target; };
+    [[nodiscard]] const frame_timing& getTiming() const noexcept { return this->timing; };
+    void invalidateScene() noexcept { this->sceneCmdBuffers.invalidate(); };
+
+    // Switches between render pass objects and dynamic rendering, false if the device lacks VK_KHR_dynamic_rendering
+    bool setDynamicRendering(bool enable);
+    [[nodiscard]] bool isDynamicRendering() const noexcept { return this->dynamicRendering; };
+
+    // Replaces the per-draw path by instanced indirect draws, one transform per instance
+    // False if culling was asked for but the device lacks drawIndirectFirstInstance, every instance is drawn then
+    bool setInstances(const std::vector<glm::mat4>& transforms, bool cull = false);
+    [[nodiscard]] std::uint32_t getInstanceCount() const noexcept { return this->instanceCount; };
+
+    // Draws only these indices into the instances, e.g. the output of culling::cull, until the next setInstances
+    // False and ignored if the device lacks drawIndirectFirstInstance
+    bool setVisibleInstances(std::vector<std::uint32_t> visible);
     void startFrame() noexcept;
     void drawFrame() noexcept;
     void endFrame() noexcept;
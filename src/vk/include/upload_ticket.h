@@ -0,0 +1,24 @@
+#ifndef DISPLAY_UPLOAD_TICKET_H
+#define DISPLAY_UPLOAD_TICKET_H
+
+#include <cstdint>
+
+class staging_uploader;
+
+// Names the staging_uploader batch an upload was recorded into, the data is on the GPU once it is ready
+class upload_ticket {
+	friend class staging_uploader;
+private:
+	staging_uploader* uploader = nullptr;
+	std::uint64_t batch = 0;
+
+	upload_ticket(staging_uploader* uploader, std::uint64_t batch) : uploader(uploader), batch(batch) {};
+public:
+	upload_ticket() = default;
+
+	[[nodiscard]] bool ready() const;
+	// Flushes the batch first if it is still being recorded
+	void wait() const;
+};
+
+#endif //DISPLAY_UPLOAD_TICKET_H
@@ -0,0 +1,80 @@
+#include "app_headless.h"
+
+#include <array>
+#include <fstream>
+#include <isdebug.h>
+#include <isprofiling.h>
+#include <profiler.h>
+#include <spdlog/spdlog.h>
+
+app_headless::app_headless(int width, int height) {
+	this->engine = std::make_unique<engine_vk>();
+
+	const vk::Extent2D extent {
+		static_cast<std::uint32_t>(width),
+		static_cast<std::uint32_t>(height)
+	};
+
+	auto offscreen = std::make_unique<offscreen_target>(*this->engine, extent);
+	this->target = offscreen.get();
+
+	this->field = std::make_unique<triangle_renderer>(*this->engine, std::move(offscreen));
+}
+
+app_headless::~app_headless() {
+	this->engine->waitDeviceIdle();
+
+	if constexpr (com::isDebug) {
+		this->engine->getAllocator().logStatistics();
+	}
+
+	if constexpr (com::isProfiling) {
+		profiler::get().writeReport(spdlog::get("graphics"));
+	}
+}
+
+void app_headless::drawFrame() noexcept {
+	this->field->startFrame();
+	this->field->drawFrame();
+	this->field->endFrame();
+}
+
+bool app_headless::writeFrame(const std::string& filename) const {
+	const auto index = this->target->getLastPresented();
+
+	if (!index) {
+		return false;
+	}
+
+	// PPM stores RGB, BGRA texels are swapped while writing
+	const auto format = this->target->getFormat();
+	const auto bgra = format == vk::Format::eB8G8R8A8Unorm || format == vk::Format::eB8G8R8A8Srgb;
+
+	if (!bgra && format != vk::Format::eR8G8B8A8Unorm && format != vk::Format::eR8G8B8A8Srgb) {
+		spdlog::get("graphics")->error("Can't write {} texels as PPM!", vk::to_string(format));
+		return false;
+	}
+
+	const auto texels = this->target->readback(index.value());
+	const auto& extent = this->target->getExtent();
+
+	std::ofstream output(filename, std::ios::binary);
+
+	if (!output.good()) {
+		spdlog::get("graphics")->error("Can't write {}!", filename);
+		return false;
+	}
+
+	output << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+
+	for (std::size_t i = 0; i < texels.size(); i += offscreen_target::BYTES_PER_TEXEL) {
+		const std::array<char, 3> rgb {
+			static_cast<char>(texels[bgra ? i + 2 : i]),
+			static_cast<char>(texels[i + 1]),
+			static_cast<char>(texels[bgra ? i : i + 2])
+		};
+		output.write(rgb.data(), rgb.size());
+	}
+
+	return output.good();
+}
@@ -1,5 +1,8 @@
 #include "app_vk.h"
 
+#include <isdebug.h>
+#include <isprofiling.h>
+#include <profiler.h>
 #include <spdlog/spdlog.h>
 
 app_vk::app_vk(int width, int height) {
@@ -12,11 +15,19 @@ app_vk::app_vk(int width, int height) {
 	}
 
 	this->engine = std::make_unique<engine_vk>(this->window.get());
-	this->field = std::make_unique<triangle_renderer>(*this->engine);
+	this->field = std::make_unique<triangle_renderer>(*this->engine, std::make_unique<swapchain>(*this->engine));
 }
 
 app_vk::~app_vk() {
 	this->engine->waitDeviceIdle();
+
+	if constexpr (com::isDebug) {
+		this->engine->getAllocator().logStatistics();
+	}
+
+	if constexpr (com::isProfiling) {
+		profiler::get().writeReport(spdlog::get("graphics"));
+	}
 }
 
 void app_vk::startFrame() noexcept {
@@ -0,0 +1,139 @@
+#include "bindless_table.h"
+
+#include <algorithm>
+#include <isdebug.h>
+#include <spdlog/spdlog.h>
+
+bindless_table::bindless_table(const engine_vk& engine) : engine(engine) {
+	const auto& properties12 = this->engine.getCapabilities().properties12;
+
+	// Every binding is visible to all stages, so the per stage limits apply as well
+	auto buffers = std::min({ bindless_table::MAX_BUFFERS, properties12.maxDescriptorSetUpdateAfterBindStorageBuffers, properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+	auto images = std::min({ bindless_table::MAX_IMAGES, properties12.maxDescriptorSetUpdateAfterBindSampledImages, properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+		properties12.maxDescriptorSetUpdateAfterBindSamplers, properties12.maxPerStageDescriptorUpdateAfterBindSamplers });
+
+	// Both tables share one stage budget, split it proportionally when they exceed it
+	const auto resources = properties12.maxPerStageUpdateAfterBindResources;
+
+	if (static_cast<std::uint64_t>(buffers) + images > resources) {
+		const auto total = static_cast<std::uint64_t>(buffers) + images;
+		buffers = static_cast<std::uint32_t>(static_cast<std::uint64_t>(buffers) * resources / total);
+		images = resources - buffers;
+	}
+
+	this->tables[static_cast<std::uint32_t>(kind::buffer)].capacity = buffers;
+	this->tables[static_cast<std::uint32_t>(kind::image)].capacity = images;
+
+	const auto stages = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eCompute;
+
+	const std::array<vk::DescriptorSetLayoutBinding, 2> bindings {
+		vk::DescriptorSetLayoutBinding{ static_cast<std::uint32_t>(kind::buffer), vk::DescriptorType::eStorageBuffer, capacity(kind::buffer), stages },
+		vk::DescriptorSetLayoutBinding{ static_cast<std::uint32_t>(kind::image), vk::DescriptorType::eCombinedImageSampler, capacity(kind::image), stages }
+	};
+
+	// Slots are written while the set is bound by recorded frames, unused and freed slots are never read
+	const auto flags = vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+	const std::array<vk::DescriptorBindingFlags, 2> bindingFlags { flags, flags };
+
+	const vk::DescriptorSetLayoutBindingFlagsCreateInfo dslbfci {
+		static_cast<std::uint32_t>(bindingFlags.size()), bindingFlags.data()
+	};
+
+	vk::DescriptorSetLayoutCreateInfo dslci {
+		vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+		static_cast<std::uint32_t>(bindings.size()), bindings.data()
+	};
+	dslci.pNext = &dslbfci;
+
+	this->descriptorLayout = this->engine.logicalDevice->createDescriptorSetLayoutUnique(dslci);
+
+	const std::array<vk::DescriptorPoolSize, 2> poolSizes {
+		vk::DescriptorPoolSize{ vk::DescriptorType::eStorageBuffer, capacity(kind::buffer) },
+		vk::DescriptorPoolSize{ vk::DescriptorType::eCombinedImageSampler, capacity(kind::image) }
+	};
+
+	const vk::DescriptorPoolCreateInfo dpci {
+		vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+		1,
+		static_cast<std::uint32_t>(poolSizes.size()), poolSizes.data()
+	};
+
+	this->descriptorPool = this->engine.logicalDevice->createDescriptorPoolUnique(dpci);
+
+	const vk::DescriptorSetAllocateInfo dsai {
+		this->descriptorPool.get(),
+		1, &this->descriptorLayout.get()
+	};
+
+	this->descriptorSet = this->engine.logicalDevice->allocateDescriptorSets(dsai)[0];
+
+	if constexpr (com::isDebug) {
+		spdlog::get("graphics")->debug("Bindless table: {} buffers, {} images", capacity(kind::buffer), capacity(kind::image));
+	}
+}
+
+bindless_table::index bindless_table::addBuffer(const vk::Buffer& buffer, vk::DeviceSize offset, vk::DeviceSize range) {
+	const auto slot = acquire(kind::buffer);
+
+	const vk::DescriptorBufferInfo dbi { buffer, offset, range };
+
+	vk::WriteDescriptorSet wds {};
+	wds.dstSet = this->descriptorSet;
+	wds.dstBinding = static_cast<std::uint32_t>(kind::buffer);
+	wds.dstArrayElement = slot;
+	wds.descriptorCount = 1;
+	wds.descriptorType = vk::DescriptorType::eStorageBuffer;
+	wds.pBufferInfo = &dbi;
+
+	this->engine.updateDescriptorSets(wds);
+
+	return slot;
+}
+
+bindless_table::index bindless_table::addImage(const vk::ImageView& view, const vk::Sampler& sampler, vk::ImageLayout layout) {
+	const auto slot = acquire(kind::image);
+
+	const vk::DescriptorImageInfo dii { sampler, view, layout };
+
+	vk::WriteDescriptorSet wds {};
+	wds.dstSet = this->descriptorSet;
+	wds.dstBinding = static_cast<std::uint32_t>(kind::image);
+	wds.dstArrayElement = slot;
+	wds.descriptorCount = 1;
+	wds.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+	wds.pImageInfo = &dii;
+
+	this->engine.updateDescriptorSets(wds);
+
+	return slot;
+}
+
+void bindless_table::remove(kind slotKind, index slot) {
+	// Frames in flight may still index the slot, so it only becomes reusable once they completed
+	this->engine.retire(slot_release(this, slotKind, slot));
+}
+
+bindless_table::index bindless_table::acquire(kind slotKind) {
+	std::scoped_lock lock(this->mutex);
+
+	auto& table = this->tables[static_cast<std::uint32_t>(slotKind)];
+
+	if (!table.free.empty()) {
+		const auto slot = table.free.back();
+		table.free.pop_back();
+		return slot;
+	}
+
+	if (table.next == table.capacity) {
+		spdlog::get("graphics")->error("Bindless table out of slots ({})!", table.capacity);
+		exit(EXIT_FAILURE);
+	}
+
+	return table.next++;
+}
+
+void bindless_table::release(kind slotKind, index slot) {
+	std::scoped_lock lock(this->mutex);
+
+	this->tables[static_cast<std::uint32_t>(slotKind)].free.emplace_back(slot);
+}
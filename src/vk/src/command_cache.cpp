@@ -0,0 +1,53 @@
+#include "command_cache.h"
+
+#include <algorithm>
+
+command_cache::command_cache(const engine_vk& engine, vk::CommandBufferLevel level, std::size_t count) : engine(engine), level(level) {
+	resize(count);
+}
+
+void command_cache::resize(std::size_t count) {
+	// Pending buffers can't be freed, they are retired and fresh ones allocated instead
+	if (!this->buffers.empty()) {
+		this->engine.retire(std::move(this->buffers));
+	}
+
+	this->buffers = this->engine.allocateCmdBuffers(vk::QueueFlagBits::eGraphics, this->level, count);
+	this->dirty.assign(count, true);
+	this->recorded.assign(count, false);
+}
+
+void command_cache::invalidate() noexcept {
+	std::fill(this->dirty.begin(), this->dirty.end(), true);
+}
+
+void command_cache::invalidate(std::size_t index) noexcept {
+	this->dirty[index] = true;
+}
+
+bool command_cache::anyDirty() const noexcept {
+	return std::any_of(this->dirty.begin(), this->dirty.end(), [](bool d) { return d; });
+}
+
+bool command_cache::anyDirtyRecorded() const noexcept {
+	for (std::size_t i = 0; i < this->buffers.size(); ++i) {
+		if (this->dirty[i] && this->recorded[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const vk::UniqueCommandBuffer& command_cache::get(std::size_t index, const std::function<void(const vk::UniqueCommandBuffer&)>& record) {
+	const auto& buffer = this->buffers[index];
+
+	if (this->dirty[index]) {
+		buffer->reset({});
+		record(buffer);
+		this->dirty[index] = false;
+		this->recorded[index] = true;
+	}
+
+	return buffer;
+}
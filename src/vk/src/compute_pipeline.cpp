@@ -0,0 +1,28 @@
+#include "compute_pipeline.h"
+
+compute_pipeline::compute_pipeline(const engine_vk& engine, const std::string& shader) : pipeline(engine) {
+	addShader(vk::ShaderStageFlagBits::eCompute, shader);
+}
+
+void compute_pipeline::finalize() {
+	finishRebuild();
+	createLayout();
+
+	this->pipeLine = builder(this->shaderStages)();
+}
+
+std::function<vk::UniquePipeline()> compute_pipeline::builder(const std::vector<vk::PipelineShaderStageCreateInfo>& stages) const {
+	const vk::ComputePipelineCreateInfo cpci {
+		{},
+		stages[0],
+		this->pipeLineLayout.get()
+	};
+
+	return [device = this->engine.logicalDevice.get(), cache = this->engine.pipelineCache.get(), cpci]() {
+		return device.createComputePipelineUnique(cache, cpci).value;
+	};
+}
+
+void compute_pipeline::dispatch(const vk::CommandBuffer& buffer, std::uint32_t groupsX, std::uint32_t groupsY, std::uint32_t groupsZ) const {
+	buffer.dispatch(groupsX, groupsY, groupsZ);
+}
@@ -0,0 +1,97 @@
+#include "descriptor_allocator.h"
+
+#include <algorithm>
+#include <isdebug.h>
+#include <spdlog/spdlog.h>
+
+descriptor_allocator::descriptor_allocator(const engine_vk& engine, std::size_t frames, std::vector<pool_ratio> ratios) : engine(engine), ratios(std::move(ratios)) {
+	this->framePools.resize(frames);
+}
+
+void descriptor_allocator::beginFrame(std::size_t frameSlot) {
+	std::scoped_lock lock(this->mutex);
+
+	this->frame = frameSlot;
+
+	auto& pools = this->framePools[frameSlot];
+
+	// One reset per pool frees every set allocated from it, much cheaper than individual frees
+	for (auto& p : pools) {
+		this->engine.logicalDevice->resetDescriptorPool(p.descriptorPool.get());
+		this->freePools.emplace_back(std::move(p));
+	}
+
+	pools.clear();
+}
+
+vk::DescriptorSet descriptor_allocator::allocate(const vk::DescriptorSetLayout& layout) {
+	std::scoped_lock lock(this->mutex);
+
+	auto& pools = this->framePools[this->frame];
+
+	if (pools.empty()) {
+		pools.emplace_back(takePool());
+	}
+
+	vk::DescriptorSetAllocateInfo dsai {
+		pools.back().descriptorPool.get(),
+		1, &layout
+	};
+
+	try {
+		return this->engine.logicalDevice->allocateDescriptorSets(dsai)[0];
+	} catch (const vk::OutOfPoolMemoryError&) {
+	} catch (const vk::FragmentedPoolError&) {
+	}
+
+	// Exhausted, the full pool stays with the frame until its reset
+	pools.emplace_back(takePool());
+	dsai.descriptorPool = pools.back().descriptorPool.get();
+
+	return this->engine.logicalDevice->allocateDescriptorSets(dsai)[0];
+}
+
+std::size_t descriptor_allocator::getPoolCount() const {
+	std::scoped_lock lock(this->mutex);
+
+	std::size_t count = this->freePools.size();
+
+	for (const auto& pools : this->framePools) {
+		count += pools.size();
+	}
+
+	return count;
+}
+
+descriptor_allocator::pool descriptor_allocator::takePool() {
+	if (!this->freePools.empty()) {
+		// Largest first, later pools were created bigger
+		const auto largest = std::max_element(this->freePools.begin(), this->freePools.end(), [](const auto& a, const auto& b) { return a.maxSets < b.maxSets; });
+
+		auto p = std::move(*largest);
+		this->freePools.erase(largest);
+		return p;
+	}
+
+	const auto maxSets = this->nextSets;
+	this->nextSets = std::min(this->nextSets * 2, descriptor_allocator::MAX_SETS);
+
+	std::vector<vk::DescriptorPoolSize> poolSizes;
+	poolSizes.reserve(this->ratios.size());
+
+	for (const auto& ratio : this->ratios) {
+		poolSizes.emplace_back(ratio.type, std::max(1u, static_cast<std::uint32_t>(ratio.perSet * static_cast<float>(maxSets))));
+	}
+
+	const vk::DescriptorPoolCreateInfo dpci {
+		{},
+		maxSets,
+		static_cast<std::uint32_t>(poolSizes.size()), poolSizes.data()
+	};
+
+	if constexpr (com::isDebug) {
+		spdlog::get("graphics")->debug("New descriptor pool: {} sets", maxSets);
+	}
+
+	return pool { this->engine.logicalDevice->createDescriptorPoolUnique(dpci), maxSets };
+}
@@ -0,0 +1,51 @@
+#include "descriptor_layout_cache.h"
+
+#include <algorithm>
+
+std::size_t descriptor_layout_cache::layout_key_hash::operator()(const layout_key& key) const noexcept {
+	std::size_t seed = std::hash<std::uint32_t>{}(static_cast<std::uint32_t>(key.flags));
+
+	const auto combine = [&seed](std::uint32_t value) {
+		seed ^= std::hash<std::uint32_t>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	};
+
+	for (const auto& binding : key.bindings) {
+		combine(binding.binding);
+		combine(static_cast<std::uint32_t>(binding.descriptorType));
+		combine(binding.descriptorCount);
+		combine(static_cast<std::uint32_t>(binding.stageFlags));
+	}
+
+	return seed;
+}
+
+vk::DescriptorSetLayout descriptor_layout_cache::get(std::vector<vk::DescriptorSetLayoutBinding> bindings, const vk::DescriptorSetLayoutCreateFlags& flags) {
+	std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.binding < b.binding; });
+
+	layout_key key { flags, std::move(bindings) };
+
+	std::scoped_lock lock(this->mutex);
+
+	if (const auto it = this->layouts.find(key); it != this->layouts.end()) {
+		return it->second.get();
+	}
+
+	const vk::DescriptorSetLayoutCreateInfo dslci {
+		flags,
+		static_cast<std::uint32_t>(key.bindings.size()),
+		key.bindings.data()
+	};
+
+	auto layout = this->device.createDescriptorSetLayoutUnique(dslci);
+	const auto handle = layout.get();
+
+	this->layouts.emplace(std::move(key), std::move(layout));
+
+	return handle;
+}
+
+std::size_t descriptor_layout_cache::size() const {
+	std::scoped_lock lock(this->mutex);
+
+	return this->layouts.size();
+}
@@ -0,0 +1,160 @@
+#include "device_capabilities.h"
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include "vk_helper.h"
+
+device_capabilities::device_capabilities(const vk::PhysicalDevice& device) : device(device),
+	properties(device.getProperties()), features(device.getFeatures()), memory(device.getMemoryProperties()),
+	queueFamilies(device.getQueueFamilyProperties()), extensions(device.enumerateDeviceExtensionProperties()) {
+
+	if (this->properties.apiVersion >= VK_API_VERSION_1_2) {
+		const auto chain = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+		this->features12 = chain.get<vk::PhysicalDeviceVulkan12Features>();
+		this->features12.pNext = nullptr;
+
+		const auto properties = device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+		this->properties12 = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+		this->properties12.pNext = nullptr;
+	}
+
+	// Structures of unsupported extensions must not be chained, so the feature is only queried when advertised
+	if (supportsExtension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+		const auto chain = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDynamicRenderingFeaturesKHR>();
+		this->dynamicRendering = chain.get<vk::PhysicalDeviceDynamicRenderingFeaturesKHR>().dynamicRendering;
+	}
+
+	for (std::size_t usage = 0; usage < this->preferredTypes.size(); ++usage) {
+		auto& types = this->preferredTypes[usage];
+
+		for (std::uint32_t i = 0; i < this->memory.memoryTypeCount; ++i) {
+			if (score(static_cast<memory_usage>(usage), i)) {
+				types.emplace_back(i);
+			}
+		}
+
+		// Higher score first, larger heap breaks ties
+		std::stable_sort(types.begin(), types.end(), [this, usage](std::uint32_t a, std::uint32_t b) {
+			const auto scoreA = score(static_cast<memory_usage>(usage), a).value();
+			const auto scoreB = score(static_cast<memory_usage>(usage), b).value();
+			return scoreA != scoreB ? scoreA > scoreB : heapSize(a) > heapSize(b);
+		});
+	}
+
+	// Without resizable BAR host writes go through the regular upload types
+	auto& rebar = this->preferredTypes[static_cast<std::size_t>(memory_usage::rebar)];
+	const auto& upload = this->preferredTypes[static_cast<std::size_t>(memory_usage::upload)];
+	rebar.insert(rebar.end(), upload.begin(), upload.end());
+
+	// Desktop GPUs have no lazily allocated memory, transient attachments then take regular VRAM
+	auto& transient = this->preferredTypes[static_cast<std::size_t>(memory_usage::transient)];
+	const auto& local = this->preferredTypes[static_cast<std::size_t>(memory_usage::device_local)];
+	transient.insert(transient.end(), local.begin(), local.end());
+}
+
+std::optional<int> device_capabilities::score(memory_usage usage, std::uint32_t type) const noexcept {
+	using flags = vk::MemoryPropertyFlagBits;
+
+	const auto propertyFlags = this->memory.memoryTypes[type].propertyFlags;
+	const auto has = [propertyFlags](vk::MemoryPropertyFlags required) { return (propertyFlags & required) == required; };
+
+	// Lazily allocated and protected memory need special handling, never hand them out implicitly
+	if (propertyFlags & flags::eProtected || (propertyFlags & flags::eLazilyAllocated && usage != memory_usage::transient)) {
+		return {};
+	}
+
+	switch (usage) {
+		case memory_usage::device_local:
+			if (!has(flags::eDeviceLocal)) {
+				return {};
+			}
+			// Keep host visible VRAM free for rebar
+			return has(flags::eHostVisible) ? 1 : 2;
+		case memory_usage::upload:
+			if (!has(flags::eHostVisible)) {
+				return {};
+			}
+			// Write combined system memory, cached memory only helps reads, non-coherent memory costs explicit flushes
+			return (has(flags::eDeviceLocal) ? 0 : 4) + (has(flags::eHostCoherent) ? 2 : 0) + (has(flags::eHostCached) ? 0 : 1);
+		case memory_usage::readback:
+			if (!has(flags::eHostVisible)) {
+				return {};
+			}
+			return (has(flags::eHostCached) ? 4 : 0) + (has(flags::eHostCoherent) ? 2 : 0) + (has(flags::eDeviceLocal) ? 0 : 1);
+		case memory_usage::rebar:
+			if (!has(flags::eDeviceLocal | flags::eHostVisible)) {
+				return {};
+			}
+			return has(flags::eHostCoherent) ? 1 : 0;
+		case memory_usage::transient:
+			if (!has(flags::eDeviceLocal | flags::eLazilyAllocated)) {
+				return {};
+			}
+			return 1;
+		default:
+			return {};
+	}
+}
+
+bool device_capabilities::supportsExtension(std::string_view name) const noexcept {
+	return std::any_of(this->extensions.begin(), this->extensions.end(), [name](const auto& extension) {
+		return name == std::string_view(extension.extensionName);
+	});
+}
+
+bool device_capabilities::hasRebar() const noexcept {
+	const auto& rebar = this->preferredTypes[static_cast<std::size_t>(memory_usage::rebar)];
+
+	return !rebar.empty() && (this->memory.memoryTypes[rebar.front()].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal);
+}
+
+bool device_capabilities::hasLazyMemory() const noexcept {
+	const auto& transient = this->preferredTypes[static_cast<std::size_t>(memory_usage::transient)];
+
+	return !transient.empty() && (this->memory.memoryTypes[transient.front()].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated);
+}
+
+bool device_capabilities::supportsBindless() const noexcept {
+	const auto& f = this->features12;
+
+	// Slots are picked at runtime, so the arrays need at least dynamically uniform indexing
+	return this->features.shaderStorageBufferArrayDynamicIndexing && this->features.shaderSampledImageArrayDynamicIndexing
+		&& f.runtimeDescriptorArray && f.descriptorBindingPartiallyBound && f.descriptorBindingUpdateUnusedWhilePending
+		&& f.descriptorBindingStorageBufferUpdateAfterBind && f.descriptorBindingSampledImageUpdateAfterBind;
+}
+
+std::optional<std::uint32_t> device_capabilities::findMemoryType(memory_usage usage, std::uint32_t typeFilter) const noexcept {
+	for (const auto type : this->preferredTypes[static_cast<std::size_t>(usage)]) {
+		if (typeFilter & (1u << type)) {
+			return type;
+		}
+	}
+
+	return {};
+}
+
+void device_capabilities::log() const {
+	const auto logger = spdlog::get("graphics");
+
+	logger->debug("Memory Heaps:");
+	for (std::uint32_t i = 0; i < this->memory.memoryHeapCount; ++i) {
+		logger->debug("\t[{}] {} MiB: {}", i, this->memory.memoryHeaps[i].size / (1024 * 1024), this->memory.memoryHeaps[i].flags);
+	}
+
+	logger->debug("Memory Types:");
+	for (std::uint32_t i = 0; i < this->memory.memoryTypeCount; ++i) {
+		logger->debug("\t[{}] heap {}: {}", i, this->memory.memoryTypes[i].heapIndex, this->memory.memoryTypes[i].propertyFlags);
+	}
+
+	constexpr std::array<const char*, static_cast<std::size_t>(memory_usage::count)> usageNames { "device local", "upload", "readback", "rebar", "transient" };
+
+	for (std::size_t usage = 0; usage < usageNames.size(); ++usage) {
+		const auto& types = this->preferredTypes[usage];
+		logger->debug("\t{}: {}", usageNames[usage], types.empty() ? std::string("none") : fmt::format("type {}", types.front()));
+	}
+
+	logger->debug("Resizable BAR: {}", hasRebar());
+	logger->debug("Lazily allocated memory: {}", hasLazyMemory());
+	logger->debug("Bindless: {}", supportsBindless());
+	logger->debug("Dynamic rendering: {}", supportsDynamicRendering());
+}
@@ -0,0 +1,74 @@
+#include "dynamic_rendering.h"
+
+dynamic_rendering::dynamic_rendering(const engine_vk& engine, const render_target& target) : engine(engine), target(target), colorFormat(target.getFormat()) {
+	this->cbiri.colorAttachmentCount = 1;
+	this->cbiri.pColorAttachmentFormats = &this->colorFormat;
+	this->cbiri.rasterizationSamples = vk::SampleCountFlagBits::e1;
+}
+
+bool dynamic_rendering::updateFormat() noexcept {
+	if (this->colorFormat == this->target.getFormat()) {
+		return false;
+	}
+
+	this->colorFormat = this->target.getFormat();
+
+	return true;
+}
+
+void dynamic_rendering::begin(const vk::CommandBuffer& buffer, const vk::Image& image, const vk::ImageView& view, const vk::Rect2D& renderArea, const vk::ClearValue& clearValue, vk::RenderingFlagsKHR flags) const {
+	// Previous contents are cleared anyway, the acquire semaphore is waited on at the color attachment output stage
+	const vk::ImageMemoryBarrier imb {
+		{},
+		vk::AccessFlagBits::eColorAttachmentWrite,
+		vk::ImageLayout::eUndefined,
+		vk::ImageLayout::eColorAttachmentOptimal,
+		VK_QUEUE_FAMILY_IGNORED,
+		VK_QUEUE_FAMILY_IGNORED,
+		image,
+		{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+	};
+
+	buffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eColorAttachmentOutput, {}, nullptr, nullptr, imb);
+
+	vk::RenderingAttachmentInfoKHR rai {};
+	rai.imageView = view;
+	rai.imageLayout = vk::ImageLayout::eColorAttachmentOptimal;
+	rai.loadOp = vk::AttachmentLoadOp::eClear;
+	rai.storeOp = vk::AttachmentStoreOp::eStore;
+	rai.clearValue = clearValue;
+
+	vk::RenderingInfoKHR ri {};
+	ri.flags = flags;
+	ri.renderArea = renderArea;
+	ri.layerCount = 1;
+	ri.colorAttachmentCount = 1;
+	ri.pColorAttachments = &rai;
+
+	buffer.beginRenderingKHR(ri, this->engine.dldid);
+}
+
+void dynamic_rendering::end(const vk::CommandBuffer& buffer, const vk::Image& image) const {
+	buffer.endRenderingKHR(this->engine.dldid);
+
+	// Presentation and copies wait on semaphores, same as the render pass' implicit dependency to bottom of pipe
+	const vk::ImageMemoryBarrier imb {
+		vk::AccessFlagBits::eColorAttachmentWrite,
+		{},
+		vk::ImageLayout::eColorAttachmentOptimal,
+		this->target.getFinalLayout(),
+		VK_QUEUE_FAMILY_IGNORED,
+		VK_QUEUE_FAMILY_IGNORED,
+		image,
+		{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+	};
+
+	buffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, nullptr, imb);
+}
+
+void dynamic_rendering::inherit(vk::CommandBufferInheritanceInfo& cbii) const noexcept {
+	cbii.pNext = &this->cbiri;
+	cbii.renderPass = nullptr;
+	cbii.subpass = 0;
+	cbii.framebuffer = nullptr;
+}
@@ -1,11 +1,14 @@
 #include "engine_vk.h"
 
 #include <array>
-#include <app_com.h>
-#include <bitset>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <isdebug.h>
 #include <optional>
 #include <spdlog/spdlog.h>
+#include "bindless_table.h"
+#include "staging_uploader.h"
 #include "vk_helper.h"
 
 VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT           messageSeverity,
@@ -47,19 +50,37 @@ engine_vk::engine_vk(GLFWwindow* window) : window(window) {
 
 	createInstance(ai);
 
-	this->surface = UniqueSurfaceKHR(new vk::SurfaceKHR, [&instance = this->instance.get()](vk::SurfaceKHR* s) {
-		instance.destroySurfaceKHR(*s);
-	});
+	// Headless engines render to offscreen targets only and never touch GLFW
+	if (!isHeadless()) {
+		this->surface = UniqueSurfaceKHR(new vk::SurfaceKHR, [&instance = this->instance.get()](vk::SurfaceKHR* s) {
+			instance.destroySurfaceKHR(*s);
+		});
 
-	auto res = static_cast<vk::Result>(glfwCreateWindowSurface(static_cast<VkInstance>(this->instance.get()), this->window, nullptr, reinterpret_cast<VkSurfaceKHR*>(this->surface.get())));
+		auto res = static_cast<vk::Result>(glfwCreateWindowSurface(static_cast<VkInstance>(this->instance.get()), this->window, nullptr, reinterpret_cast<VkSurfaceKHR*>(this->surface.get())));
 
-	if (res != vk::Result::eSuccess) {
-		spdlog::get("glfw")->error("Can't create vk::SurfaceKHR for presentation!");
-		exit(EXIT_FAILURE);
+		if (res != vk::Result::eSuccess) {
+			spdlog::get("glfw")->error("Can't create vk::SurfaceKHR for presentation!");
+			exit(EXIT_FAILURE);
+		}
 	}
 
 	selectPhysicalDevice();
 	createLogicalDevice();
+	loadPipelineCache();
+
+	this->uploader = std::make_unique<staging_uploader>(*this);
+
+	if (this->capabilities->supportsBindless()) {
+		this->bindless = std::make_unique<bindless_table>(*this);
+	}
+}
+
+engine_vk::~engine_vk() {
+	this->logicalDevice->waitIdle();
+
+	this->retiredResources.clear();
+
+	savePipelineCache();
 }
 
 void engine_vk::createInstance(vk::ApplicationInfo& ai) noexcept {
@@ -99,11 +120,15 @@ void engine_vk::createInstance(vk::ApplicationInfo& ai) noexcept {
 
 	const std::string debugExtension = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
 
-	const auto getRequiredInstanceExtensions = [&debugExtension]() {
-		std::uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	const auto getRequiredInstanceExtensions = [&debugExtension, headless = isHeadless()]() {
+		std::vector<const char*> extensions;
+
+		if (!headless) {
+			std::uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		if constexpr (com::isDebug) {
 			extensions.emplace_back(debugExtension.c_str());
@@ -170,20 +195,41 @@ typedef struct QueueFamilyIndices {
 const std::string swapChainExtension = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
 const std::string shaderDrawParameters = VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME;
 
-auto getRequiredDeviceExtensions() {
+auto getRequiredDeviceExtensions(bool headless) {
 	std::vector<const char*> extensions;
 
-	extensions.emplace_back(swapChainExtension.c_str());
+	if (!headless) {
+		extensions.emplace_back(swapChainExtension.c_str());
+	}
 	//extensions.emplace_back(shaderDrawParameters.c_str());
 
 	return extensions;
 };
 
+// Higher is better, CPU implementations such as lavapipe or SwiftShader are still accepted
+int deviceTypeScore(vk::PhysicalDeviceType type) noexcept {
+	switch (type) {
+		case vk::PhysicalDeviceType::eDiscreteGpu:
+			return 4;
+		case vk::PhysicalDeviceType::eIntegratedGpu:
+			return 3;
+		case vk::PhysicalDeviceType::eVirtualGpu:
+			return 2;
+		case vk::PhysicalDeviceType::eCpu:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
 void engine_vk::selectPhysicalDevice() noexcept {
 	const auto availableDevices = this->instance->enumeratePhysicalDevices();
 
-	const auto findQueueFamilies = [surface = this->surface.get()](const vk::PhysicalDevice &d) {
-		const auto availableFamilies = d.getQueueFamilyProperties();
+	const bool headless = isHeadless();
+
+	const auto findQueueFamilies = [surface = this->surface.get(), headless](const device_capabilities &caps) {
+		const auto& d = caps.device;
+		const auto& availableFamilies = caps.queueFamilies;
 
 		QueueFamilyIndices indices;
 
@@ -196,76 +242,95 @@ void engine_vk::selectPhysicalDevice() noexcept {
 			}
 		}
 
+		std::optional<std::uint32_t> dmaFamily;
+		std::optional<std::uint32_t> nonGraphicsFamily;
+
 		for(std::size_t i = 0; i < availableFamilies.size(); ++i) {
 			const auto& family = availableFamilies[i];
 
 			bool supportsGraphics = static_cast<bool>(family.queueFlags & vk::QueueFlagBits::eGraphics);
+			bool supportsCompute = static_cast<bool>(family.queueFlags & vk::QueueFlagBits::eCompute);
 			bool supportsTransfer = static_cast<bool>(family.queueFlags & vk::QueueFlagBits::eTransfer);
-			bool supportsPresent = d.getSurfaceSupportKHR(i, *surface);
+			bool supportsPresent = headless || d.getSurfaceSupportKHR(i, *surface);
 
 			const auto index = static_cast<std::uint32_t>(i);
 
-			if (supportsGraphics && supportsPresent) {
+			if (supportsGraphics && supportsPresent && !indices.graphicsFamily) {
 				indices.graphicsFamily = index;
 			}
 
-			if (supportsTransfer) {
-				indices.transferFamily = index;
+			if (supportsTransfer && !supportsGraphics && !supportsCompute && !dmaFamily) {
+				dmaFamily = index;
+			} else if (supportsTransfer && !supportsGraphics && !nonGraphicsFamily) {
+				nonGraphicsFamily = index;
 			}
+		}
 
-			if (indices.isComplete())
-				break;
+		// Prefer the copy engines of a transfer-only family, then async compute, otherwise share the graphics family
+		if (dmaFamily) {
+			indices.transferFamily = dmaFamily;
+		} else if (nonGraphicsFamily) {
+			indices.transferFamily = nonGraphicsFamily;
+		} else {
+			indices.transferFamily = indices.graphicsFamily;
 		}
 
 		return indices;
 	};
 
-	const auto isDeviceSuitable = [surface = this->surface.get(), &findQueueFamilies](const vk::PhysicalDevice &d) {
-		const auto& properties = d.getProperties();
-		const auto& features = d.getFeatures();
-
-		const auto requiredExtensions = getRequiredDeviceExtensions();
-		const auto availableExtensions = d.enumerateDeviceExtensionProperties();
+	const auto isDeviceSuitable = [surface = this->surface.get(), headless](const device_capabilities &caps) {
+		const auto& d = caps.device;
+		const auto requiredExtensions = getRequiredDeviceExtensions(headless);
 
-		bool extensionsSupported = vk_helper::extensionsSupported(requiredExtensions, availableExtensions);
-		bool swapChainSupported = false;
+		bool extensionsSupported = vk_helper::extensionsSupported(requiredExtensions, caps.extensions);
+		bool timelineSupported = static_cast<bool>(caps.features12.timelineSemaphore);
+		bool swapChainSupported = headless;
 
-		if (extensionsSupported) {
+		if (extensionsSupported && !headless) {
 			const auto formats = d.getSurfaceFormatsKHR(*surface);
 			const auto presentModes = d.getSurfacePresentModesKHR(*surface);
 			swapChainSupported = !formats.empty() && !presentModes.empty();
 		}
 
-		return
-		extensionsSupported && swapChainSupported &&
-		properties.deviceType == vk::PhysicalDeviceType::eDiscreteGpu &&
-		features.geometryShader && features.vertexPipelineStoresAndAtomics;
+		return extensionsSupported && swapChainSupported && timelineSupported;
 	};
 
 	if constexpr (com::isDebug)
 		spdlog::get("graphics")->debug("Physical Devices:");
 
+	int bestScore = -1;
+
 	for(const auto& device : availableDevices) {
+		auto caps = std::make_unique<device_capabilities>(device);
+		const auto& properties = caps->properties;
 
 		if constexpr (com::isDebug) {
-			const auto& properties = device.getProperties();
-			spdlog::get("graphics")->debug("\t{}", properties.deviceName);
+			spdlog::get("graphics")->debug("\t{} ({})", properties.deviceName, properties.deviceType);
 		}
 
-		const bool deviceSuitable = isDeviceSuitable(device);
-		const auto& indices = findQueueFamilies(device);
+		const bool deviceSuitable = isDeviceSuitable(*caps);
+		const auto& indices = findQueueFamilies(*caps);
 		const bool supportsFamilies = indices.isComplete();
+		const int score = deviceTypeScore(properties.deviceType);
 
-		if (deviceSuitable && supportsFamilies) {
+		if (deviceSuitable && supportsFamilies && score > bestScore) {
+			bestScore = score;
 			this->physicalDevice = device;
+			this->capabilities = std::move(caps);
 			this->graphicsFamilyIndex = indices.graphicsFamily.value();
 			this->transferFamilyIndex = indices.transferFamily.value();
-			break;
 		}
 	}
 
-	if constexpr (com::isDebug)
-		spdlog::get("graphics")->debug("Selected: {} (Graphics {} Transfer {})", this->physicalDevice.getProperties().deviceName, this->graphicsFamilyIndex, this->transferFamilyIndex);
+	if (!this->physicalDevice) {
+		spdlog::get("graphics")->error("No suitable Physical Device found!");
+		exit(EXIT_FAILURE);
+	}
+
+	if constexpr (com::isDebug) {
+		spdlog::get("graphics")->debug("Selected: {} (Graphics {} Transfer {})", this->capabilities->properties.deviceName, this->graphicsFamilyIndex, this->transferFamilyIndex);
+		this->capabilities->log();
+	}
 }
 
 void engine_vk::createLogicalDevice() noexcept {
@@ -273,12 +338,10 @@ void engine_vk::createLogicalDevice() noexcept {
 
 	const std::array<float, 2> defaultPriority{ 1.0f, 1.0f };
 
-	const bool separateQueues = (this->graphicsFamilyIndex != this->transferFamilyIndex);
-
-	const auto availableFamilies = this->physicalDevice.getQueueFamilyProperties();
+	const auto& availableFamilies = this->capabilities->queueFamilies;
 	const auto graphicsQueueSize = availableFamilies[this->graphicsFamilyIndex].queueCount;
 
-	if (separateQueues) {
+	if (separateQueues()) {
 		const vk::DeviceQueueCreateInfo dqci_graphics {
 			{},
 			this->graphicsFamilyIndex,
@@ -287,7 +350,7 @@ void engine_vk::createLogicalDevice() noexcept {
 
 		const vk::DeviceQueueCreateInfo dqci_transfer {
 			{},
-			this->graphicsFamilyIndex,
+			this->transferFamilyIndex,
 			1,&defaultPriority[1]
 		};
 		queueInfos.emplace_back(dqci_graphics);
@@ -308,25 +371,76 @@ void engine_vk::createLogicalDevice() noexcept {
 		queueInfos.emplace_back(dqci_combo);
 	}
 
-	const auto requiredExtensions = getRequiredDeviceExtensions();
+	auto requiredExtensions = getRequiredDeviceExtensions(isHeadless());
+
+	// Optional, renderers fall back to render pass objects without it
+	if (this->capabilities->supportsDynamicRendering()) {
+		requiredExtensions.emplace_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+	}
+
+	const auto& supportedFeatures = this->capabilities->features;
 
 	vk::PhysicalDeviceFeatures pdf {};
 
     // TODO: customizable pdf request ?
-	pdf.geometryShader = VK_TRUE;
-	pdf.vertexPipelineStoresAndAtomics = VK_TRUE;
+	// Only enabled where available, CPU implementations commonly lack geometry shaders
+	pdf.geometryShader = supportedFeatures.geometryShader;
+	pdf.vertexPipelineStoresAndAtomics = supportedFeatures.vertexPipelineStoresAndAtomics;
+	pdf.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	pdf.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+
+	vk::PhysicalDeviceVulkan12Features pdf12 {};
+	pdf12.timelineSemaphore = VK_TRUE;
+	pdf12.drawIndirectCount = this->capabilities->features12.drawIndirectCount;
+
+	if (this->capabilities->supportsBindless()) {
+		pdf.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+		pdf.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+		pdf12.runtimeDescriptorArray = VK_TRUE;
+		pdf12.descriptorBindingPartiallyBound = VK_TRUE;
+		pdf12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		pdf12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		pdf12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		pdf12.shaderStorageBufferArrayNonUniformIndexing = this->capabilities->features12.shaderStorageBufferArrayNonUniformIndexing;
+		pdf12.shaderSampledImageArrayNonUniformIndexing = this->capabilities->features12.shaderSampledImageArrayNonUniformIndexing;
+	}
 
-	const vk::DeviceCreateInfo dci {
+	vk::DeviceCreateInfo dci {
 		{},
 		static_cast<std::uint32_t>(queueInfos.size()), queueInfos.data(),
 		0,nullptr,
 		static_cast<std::uint32_t>(requiredExtensions.size()), requiredExtensions.data(),
 		&pdf
 	};
+	dci.pNext = &pdf12;
+
+	vk::PhysicalDeviceDynamicRenderingFeaturesKHR pdrf {
+		this->capabilities->supportsDynamicRendering()
+	};
+
+	if (this->capabilities->supportsDynamicRendering()) {
+		pdf12.pNext = &pdrf;
+	}
 
 	this->logicalDevice = this->physicalDevice.createDeviceUnique(dci);
 
-	if (separateQueues || graphicsQueueSize == 1) {
+	// Extension commands such as vkCmdBeginRenderingKHR are only reachable through the device
+	this->dldid.init(this->logicalDevice.get());
+
+	const vk::SemaphoreTypeCreateInfo stci {
+		vk::SemaphoreType::eTimeline,
+		0
+	};
+
+	vk::SemaphoreCreateInfo sci {};
+	sci.pNext = &stci;
+
+	for (auto& t : this->timelines) {
+		t.semaphore = this->logicalDevice->createSemaphoreUnique(sci);
+	}
+
+	// Without a dedicated family a second graphics queue still lets uploads overlap rendering
+	if (separateQueues() || graphicsQueueSize == 1) {
 		this->graphicsQueue = this->logicalDevice->getQueue(this->graphicsFamilyIndex, 0);
 		this->transferQueue = this->logicalDevice->getQueue(this->transferFamilyIndex, 0);
 	} else {
@@ -346,17 +460,97 @@ void engine_vk::createLogicalDevice() noexcept {
 
 	this->graphicsPool = this->logicalDevice->createCommandPoolUnique(cpci_graphics);
 	this->transferPool = this->logicalDevice->createCommandPoolUnique(cpci_transfer);
+
+	this->allocator = std::make_unique<memory_allocator>(this->logicalDevice.get(), this->capabilities->memory, this->capabilities->limits().nonCoherentAtomSize);
+	this->layoutCache = std::make_unique<descriptor_layout_cache>(this->logicalDevice.get());
+	this->shaderCache = std::make_unique<shader_module_cache>(this->logicalDevice.get());
 }
 
-vk::UniqueShaderModule engine_vk::createShaderModule(const std::string &filename) const {
-	const auto buffer = app_com::loadShader(filename);
+void engine_vk::loadPipelineCache() {
+	std::vector<std::uint8_t> data;
+
+	std::ifstream input(engine_vk::PIPELINE_CACHE_FILE, std::ios::binary);
+
+	if (input.good()) {
+		data.assign(std::istreambuf_iterator<char>(input), {});
+	}
+
+	// Layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE: length, version, vendorID, deviceID, pipelineCacheUUID
+	const auto isCompatible = [&properties = this->capabilities->properties](const std::vector<std::uint8_t>& cache) {
+		constexpr std::size_t headerSize = 4 * sizeof(std::uint32_t) + VK_UUID_SIZE;
+
+		if (cache.size() < headerSize) {
+			return false;
+		}
+
+		std::array<std::uint32_t, 4> header{};
+		std::memcpy(header.data(), cache.data(), sizeof(header));
+
+		return header[0] >= headerSize && header[0] <= cache.size() &&
+			   header[1] == static_cast<std::uint32_t>(vk::PipelineCacheHeaderVersion::eOne) &&
+			   header[2] == properties.vendorID &&
+			   header[3] == properties.deviceID &&
+			   std::memcmp(cache.data() + sizeof(header), properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+	};
+
+	if (!data.empty() && !isCompatible(data)) {
+		if constexpr (com::isDebug) {
+			spdlog::get("graphics")->debug("Discarding {}: created by a different device or driver", engine_vk::PIPELINE_CACHE_FILE);
+		}
+
+		data.clear();
+	}
 
-	const vk::ShaderModuleCreateInfo smci {
+	if constexpr (com::isDebug) {
+		spdlog::get("graphics")->debug("Pipeline cache: {} bytes loaded", data.size());
+	}
+
+	const vk::PipelineCacheCreateInfo pcci {
 		{},
-		static_cast<std::uint32_t>(buffer.size()), reinterpret_cast<const std::uint32_t*>(buffer.data())
+		data.size(), data.data()
 	};
 
-	return this->logicalDevice->createShaderModuleUnique(smci);
+	this->pipelineCache = this->logicalDevice->createPipelineCacheUnique(pcci);
+}
+
+void engine_vk::savePipelineCache() const {
+	const auto data = this->logicalDevice->getPipelineCacheData(this->pipelineCache.get());
+
+	// Written next to it and renamed, a crash or another engine saving at the same time never leaves a partial cache
+	const std::filesystem::path output = engine_vk::PIPELINE_CACHE_FILE;
+	auto temporary = output;
+	temporary += ".tmp" + std::to_string(reinterpret_cast<std::uintptr_t>(this));
+
+	std::error_code error;
+
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+
+		if (!file.good()) {
+			spdlog::get("graphics")->warn("Can't write {}!", temporary.string());
+			return;
+		}
+
+		file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+		if (!file.good()) {
+			spdlog::get("graphics")->warn("Can't write {}!", temporary.string());
+			file.close();
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporary, output, error);
+
+	if (error) {
+		spdlog::get("graphics")->warn("Can't replace {}: {}", output.string(), error.message());
+		std::filesystem::remove(temporary, error);
+	}
+}
+
+std::string engine_vk::getDeviceName() const {
+	return this->capabilities->properties.deviceName;
 }
 
 vk::UniqueSemaphore engine_vk::createSemaphore() const {
@@ -371,22 +565,38 @@ vk::UniqueFence engine_vk::createFence(vk::FenceCreateFlagBits flags) const {
 	return this->logicalDevice->createFenceUnique(fci);
 }
 
-std::optional<std::uint32_t> engine_vk::findMemoryType(std::uint32_t typeFilter, const vk::MemoryPropertyFlags& properties) const noexcept {
-	const vk::PhysicalDeviceMemoryProperties memProperties = this->physicalDevice.getMemoryProperties();
+std::uint32_t engine_vk::memoryType(std::uint32_t typeFilter, memory_usage memoryUsage) const {
+	const auto type = this->capabilities->findMemoryType(memoryUsage, typeFilter);
 
-	const auto& bits = std::bitset<32>(typeFilter);
-	for (std::uint32_t i = 0; i < memProperties.memoryTypeCount; ++i) {
-		const auto& memoryType = memProperties.memoryTypes[i];
+	if (!type) {
+		spdlog::get("graphics")->error("No memory type for usage {} in type bits {:#x}!", static_cast<std::size_t>(memoryUsage), typeFilter);
+		throw std::runtime_error("No suitable memory type");
+	}
 
-		if constexpr (com::isDebug) {
-			spdlog::get("graphics")->debug("[{}] Mem type: {}", i, memoryType.propertyFlags);
-		}
+	return type.value();
+}
 
-		if (bits[i] && (memoryType.propertyFlags & properties)) {
-			return i;
-		}
+std::uint32_t engine_vk::familyIndex(const vk::QueueFlagBits& family) const noexcept {
+	switch(family) {
+		case vk::QueueFlagBits::eTransfer:
+			return this->transferFamilyIndex;
+		case vk::QueueFlagBits::eGraphics:
+		default:
+			return this->graphicsFamilyIndex;
 	}
-	return {};
+}
+
+vk::UniqueCommandPool engine_vk::createCommandPool(const vk::QueueFlagBits& family, const vk::CommandPoolCreateFlags& flags) const {
+	const vk::CommandPoolCreateInfo cpci {
+		flags,
+		familyIndex(family)
+	};
+
+	return this->logicalDevice->createCommandPoolUnique(cpci);
+}
+
+void engine_vk::resetCommandPool(const vk::CommandPool& pool) const {
+	this->logicalDevice->resetCommandPool(pool);
 }
 
 std::vector<vk::UniqueCommandBuffer> engine_vk::allocateCmdBuffers(const vk::QueueFlagBits& family, const vk::CommandBufferLevel& level, std::size_t count) const {
@@ -403,8 +613,12 @@ std::vector<vk::UniqueCommandBuffer> engine_vk::allocateCmdBuffers(const vk::Que
 			break;
 	}
 
+	return allocateCmdBuffers(cmdPool, level, count);
+}
+
+std::vector<vk::UniqueCommandBuffer> engine_vk::allocateCmdBuffers(const vk::CommandPool& pool, const vk::CommandBufferLevel& level, std::size_t count) const {
 	const vk::CommandBufferAllocateInfo cbai {
-			cmdPool,
+			pool,
 			level,
 			static_cast<std::uint32_t>(count)
 	};
@@ -412,7 +626,7 @@ std::vector<vk::UniqueCommandBuffer> engine_vk::allocateCmdBuffers(const vk::Que
 	return this->logicalDevice->allocateCommandBuffersUnique(cbai);
 }
 
-engine_vk::vk_buffer engine_vk::createBuffer(vk::DeviceSize size, const vk::BufferUsageFlags& usage, const vk::MemoryPropertyFlags& properties) const {
+engine_vk::vk_buffer engine_vk::createBuffer(vk::DeviceSize size, const vk::BufferUsageFlags& usage, memory_usage memoryUsage) const {
 	const vk::BufferCreateInfo bci {
 		{},
 		size,
@@ -424,42 +638,167 @@ engine_vk::vk_buffer engine_vk::createBuffer(vk::DeviceSize size, const vk::Buff
 
 	const auto& memRequirements = this->logicalDevice->getBufferMemoryRequirements(buffer.get());
 
-	const vk::MemoryAllocateInfo mai {
-		memRequirements.size,
-		findMemoryType(memRequirements.memoryTypeBits, properties).value()
+	auto bufferMemory = this->allocator->allocate(memRequirements, memoryType(memRequirements.memoryTypeBits, memoryUsage));
+
+	this->logicalDevice->bindBufferMemory(buffer.get(), bufferMemory.getMemory(), bufferMemory.getOffset());
+
+	return engine_vk::vk_buffer(bufferMemory, buffer);
+}
+
+engine_vk::vk_image engine_vk::createImage(const vk::Extent2D& extent, vk::Format format, const vk::ImageUsageFlags& usage, memory_usage memoryUsage, const vk::ImageAspectFlags& aspect) const {
+	const vk::ImageCreateInfo ici {
+		{},
+		vk::ImageType::e2D,
+		format,
+		vk::Extent3D{ extent.width, extent.height, 1 },
+		1,
+		1,
+		vk::SampleCountFlagBits::e1,
+		vk::ImageTiling::eOptimal,
+		usage,
+		vk::SharingMode::eExclusive
 	};
 
-	auto bufferMemory = this->logicalDevice->allocateMemoryUnique(mai);
+	auto image = this->logicalDevice->createImageUnique(ici);
 
-	this->logicalDevice->bindBufferMemory(buffer.get(), bufferMemory.get(), 0);
+	auto memRequirements = this->logicalDevice->getImageMemoryRequirements(image.get());
 
-	return engine_vk::vk_buffer(bufferMemory, buffer);
+	// Optimal images share blocks with linear buffers, so give them whole bufferImageGranularity pages
+	const auto granularity = this->capabilities->limits().bufferImageGranularity;
+	memRequirements.alignment = std::max(memRequirements.alignment, granularity);
+	memRequirements.size = (memRequirements.size + granularity - 1) / granularity * granularity;
+
+	auto imageMemory = this->allocator->allocate(memRequirements, memoryType(memRequirements.memoryTypeBits, memoryUsage));
+
+	this->logicalDevice->bindImageMemory(image.get(), imageMemory.getMemory(), imageMemory.getOffset());
+
+	const vk::ImageViewCreateInfo ivci {
+		{},
+		image.get(),
+		vk::ImageViewType::e2D,
+		format,
+		{},
+		vk::ImageSubresourceRange{ aspect, 0, 1, 0, 1 }
+	};
+
+	auto view = this->logicalDevice->createImageViewUnique(ivci);
+
+	return engine_vk::vk_image(imageMemory, image, view);
 }
 
-vk::Result engine_vk::submit(const vk::QueueFlagBits& family, const vk::SubmitInfo &si, const vk::Fence& fence) const noexcept {
-	switch(family) {
-		case vk::QueueFlagBits::eGraphics:
-			return this->graphicsQueue.submit(1, &si, fence);
-		case vk::QueueFlagBits::eTransfer:
-			return this->transferQueue.submit(1, &si, fence);
-		default:
-			return vk::Result::eErrorUnknown;
+std::uint64_t engine_vk::submit(const vk::QueueFlagBits& family, const std::vector<submission>& submissions) const {
+	std::scoped_lock lock(this->queueMutex);
+
+	auto& signaled = timeline(family);
+	const auto count = submissions.size();
+
+	// Only advanced once the queue accepted the batch, a failed submit signals nothing
+	auto next = signaled.submitted;
+
+	std::vector<std::vector<vk::Semaphore>> waitSemaphores(count);
+	std::vector<std::vector<vk::PipelineStageFlags>> waitStages(count);
+	std::vector<std::vector<std::uint64_t>> waitValues(count);
+	std::vector<std::vector<vk::Semaphore>> signalSemaphores(count);
+	std::vector<std::vector<std::uint64_t>> signalValues(count);
+	std::vector<vk::TimelineSemaphoreSubmitInfo> tssi(count);
+	std::vector<vk::SubmitInfo> si(count);
+
+	for (std::size_t i = 0; i < count; ++i) {
+		const auto& s = submissions[i];
+
+		// Binary semaphores ignore their value, it just has to be present
+		waitSemaphores[i] = s.waitSemaphores;
+		waitStages[i] = s.waitStages;
+		waitValues[i].assign(s.waitSemaphores.size(), 0);
+
+		for (const auto& wait : s.timelineWaits) {
+			waitSemaphores[i].emplace_back(timeline(wait.family).semaphore.get());
+			waitStages[i].emplace_back(wait.stage);
+			waitValues[i].emplace_back(wait.value);
+		}
+
+		signalSemaphores[i] = s.signalSemaphores;
+		signalValues[i].assign(s.signalSemaphores.size(), 0);
+
+		signalSemaphores[i].emplace_back(signaled.semaphore.get());
+		signalValues[i].emplace_back(++next);
+
+		tssi[i] = vk::TimelineSemaphoreSubmitInfo {
+			static_cast<std::uint32_t>(waitValues[i].size()), waitValues[i].data(),
+			static_cast<std::uint32_t>(signalValues[i].size()), signalValues[i].data()
+		};
+
+		si[i] = vk::SubmitInfo {
+			static_cast<std::uint32_t>(waitSemaphores[i].size()), waitSemaphores[i].data(),
+			waitStages[i].data(),
+			static_cast<std::uint32_t>(s.cmdBuffers.size()), s.cmdBuffers.data(),
+			static_cast<std::uint32_t>(signalSemaphores[i].size()), signalSemaphores[i].data()
+		};
+		si[i].pNext = &tssi[i];
 	}
+
+	queue(family).submit(si, {});
+	signaled.submitted = next;
+
+	return next;
 }
 
-vk::Result engine_vk::present(const vk::PresentInfoKHR& pi) const {
-	return this->graphicsQueue.presentKHR(pi);
+std::uint64_t engine_vk::submittedValue(const vk::QueueFlagBits& family) const noexcept {
+	std::scoped_lock lock(this->queueMutex);
+	return timeline(family).submitted;
 }
 
-void engine_vk::waitFence(const vk::Fence &fence) const noexcept {
-	this->logicalDevice->waitForFences(1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+std::uint64_t engine_vk::completedValue(const vk::QueueFlagBits& family) const {
+	return this->logicalDevice->getSemaphoreCounterValue(timeline(family).semaphore.get());
 }
 
-void engine_vk::resetFence(const vk::Fence &fence) const noexcept {
-	this->logicalDevice->resetFences(1, &fence);
+void engine_vk::waitTimeline(const vk::QueueFlagBits& family, std::uint64_t value) const noexcept {
+	const vk::SemaphoreWaitInfo swi {
+		{},
+		1, &timeline(family).semaphore.get(),
+		&value
+	};
+
+	static_cast<void>(this->logicalDevice->waitSemaphores(swi, std::numeric_limits<uint64_t>::max()));
+}
+
+std::size_t engine_vk::collectRetired() const {
+	const auto graphicsDone = completedValue(vk::QueueFlagBits::eGraphics);
+	const auto transferDone = completedValue(vk::QueueFlagBits::eTransfer);
+
+	std::deque<retired_resource> done;
+
+	{
+		std::scoped_lock lock(this->retireMutex);
+
+		// Retired in submission order, the first pending entry ends the completed prefix
+		while (!this->retiredResources.empty()) {
+			const auto& front = this->retiredResources.front();
+
+			if (front.values[0] > graphicsDone || front.values[1] > transferDone) {
+				break;
+			}
+
+			done.push_back(std::move(this->retiredResources.front()));
+			this->retiredResources.pop_front();
+		}
+	}
+
+	// Destroyed outside the lock, freeing memory takes the allocator's
+	done.clear();
+
+	std::scoped_lock lock(this->retireMutex);
+	return this->retiredResources.size();
+}
+
+vk::Result engine_vk::present(const vk::PresentInfoKHR& pi) const {
+	std::scoped_lock lock(this->queueMutex);
+	return this->graphicsQueue.presentKHR(pi);
 }
 
 void engine_vk::waitQueueIdle(const vk::QueueFlagBits& family) const noexcept {
+	std::scoped_lock lock(this->queueMutex);
+
 	switch(family) {
 		case vk::QueueFlagBits::eGraphics:
 			return this->graphicsQueue.waitIdle();
@@ -474,57 +813,45 @@ void engine_vk::waitDeviceIdle() const noexcept {
 	this->logicalDevice->waitIdle();
 }
 
-void engine_vk::executeOnQueue(const vk::QueueFlagBits& family, const std::function<void(const vk::CommandBuffer&)>& lambda) const {
-	vk::UniqueCommandBuffer commandBuffer = std::move(allocateCmdBuffers(family, vk::CommandBufferLevel::ePrimary, 1)[0]);
-
-	vk::CommandBufferBeginInfo cbbi {};
-	cbbi.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
-	commandBuffer->begin(cbbi);
-
-	lambda(*commandBuffer);
-
-	commandBuffer->end();
-
-	vk::SubmitInfo si {};
-	si.commandBufferCount = 1;
-	si.pCommandBuffers = &commandBuffer.get();
-
-	static_cast<void>(submit(family, si, {}));
-	waitQueueIdle(family);
-}
-
 void engine_vk::copy(engine_vk::vk_buffer& bufferDst, const void* bufferSrc, vk::DeviceSize offsetDst, vk::DeviceSize offsetSrc, vk::DeviceSize size) const {
-	memory_mapping map(*this, bufferDst.memory.get(), offsetDst, size);
 	const auto bufferSrcOffset = static_cast<const unsigned char*>(bufferSrc) + offsetSrc;
-	std::memcpy(map.get(), bufferSrcOffset, size);
+	std::memcpy(static_cast<unsigned char*>(bufferDst.data()) + offsetDst, bufferSrcOffset, size);
+	bufferDst.flush(offsetDst, size);
 }
 
 void engine_vk::copy(void *bufferDst, const engine_vk::vk_buffer &bufferSrc, vk::DeviceSize offsetDst, vk::DeviceSize offsetSrc, vk::DeviceSize size) const {
-	memory_mapping map(*this, bufferSrc.memory.get(), offsetSrc, size);
+	bufferSrc.invalidate(offsetSrc, size);
 	const auto bufferDstOffset = static_cast<unsigned char*>(bufferDst) + offsetDst;
-	std::memcpy(bufferDstOffset, map.get(), size);
+	std::memcpy(bufferDstOffset, static_cast<const unsigned char*>(bufferSrc.data()) + offsetSrc, size);
 }
 
-void engine_vk::copy(vk_buffer& bufferDst, const vk_buffer& bufferSrc, vk::DeviceSize offsetDst, vk::DeviceSize offsetSrc, vk::DeviceSize size) const {
-	vk::BufferCopy copyRegion { offsetSrc, offsetDst, size };
+std::pair<engine_vk::vk_buffer, upload_ticket> engine_vk::createLocalBufferWithData(vk::DeviceSize size, vk::BufferUsageFlagBits usage, const void *dataPointer) const {
+	auto local = createBuffer(size, usage | vk::BufferUsageFlagBits::eTransferDst, memory_usage::device_local);
 
-	executeOnQueue(vk::QueueFlagBits::eTransfer,
-				[&bufferDst, &bufferSrc, &copyRegion](const vk::CommandBuffer& buffer) {
-					buffer.copyBuffer(bufferSrc.buffer.get(), bufferDst.buffer.get(), 1, &copyRegion);
-				}
-	);
+	const auto ticket = this->uploader->upload(local, 0, dataPointer, size);
+
+	return { std::move(local), ticket };
+}
+
+void engine_vk::updateDescriptorSets(const vk::WriteDescriptorSet& wds) const noexcept {
+	this->logicalDevice->updateDescriptorSets(1, &wds, 0, nullptr);
 }
 
-engine_vk::vk_buffer engine_vk::createLocalBufferWithData(vk::DeviceSize size, vk::BufferUsageFlagBits usage, const void *dataPointer) const {
-	auto staging = createBuffer(size, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-	copy(staging, dataPointer, 0, 0, size);
+void engine_vk::updateDescriptorSets(const std::vector<vk::WriteDescriptorSet>& writes) const noexcept {
+	this->logicalDevice->updateDescriptorSets(static_cast<std::uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
 
-	auto local = createBuffer(size, usage | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal);
-	copy(local, staging, 0, 0, size);
+vk::UniqueDescriptorUpdateTemplate engine_vk::createUpdateTemplate(const vk::DescriptorSetLayout& layout, const std::vector<vk::DescriptorUpdateTemplateEntry>& entries) const {
+	const vk::DescriptorUpdateTemplateCreateInfo dutci {
+		{},
+		static_cast<std::uint32_t>(entries.size()), entries.data(),
+		vk::DescriptorUpdateTemplateType::eDescriptorSet,
+		layout
+	};
 
-	return local;
+	return this->logicalDevice->createDescriptorUpdateTemplateUnique(dutci);
 }
 
-void engine_vk::updateDescriptorSets(const vk::WriteDescriptorSet& wds) const noexcept {
-	this->logicalDevice->updateDescriptorSets(1, &wds, 0, nullptr);
+void engine_vk::updateDescriptorSet(const vk::DescriptorSet& set, const vk::DescriptorUpdateTemplate& updateTemplate, const void* data) const noexcept {
+	this->logicalDevice->updateDescriptorSetWithTemplate(set, updateTemplate, data);
 }
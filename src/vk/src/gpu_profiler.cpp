@@ -0,0 +1,117 @@
+#include "gpu_profiler.h"
+
+#include <profiler.h>
+#include <spdlog/spdlog.h>
+
+gpu_profiler::gpu_profiler(const engine_vk& engine, std::size_t slots) : engine(engine), slots(slots) {
+	const auto& capabilities = this->engine.getCapabilities();
+	const auto validBits = capabilities.queueFamilies[this->engine.graphicsFamilyIndex].timestampValidBits;
+
+	this->nsPerTick = static_cast<double>(capabilities.limits().timestampPeriod);
+	this->validMask = validBits >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << validBits) - 1;
+
+	if (!isSupported()) {
+		spdlog::get("graphics")->warn("Graphics queue doesn't support timestamps, GPU profiling disabled");
+		return;
+	}
+
+	createQueryPool();
+}
+
+void gpu_profiler::resize(std::size_t slots) {
+	this->slots = slots;
+
+	if (isSupported()) {
+		createQueryPool();
+	}
+}
+
+void gpu_profiler::createQueryPool() {
+	const vk::QueryPoolCreateInfo qpci {
+		{},
+		vk::QueryType::eTimestamp,
+		firstQuery(this->slots)
+	};
+
+	if (this->queryPool) {
+		this->engine.retire(std::move(this->queryPool));
+	}
+
+	this->queryPool = this->engine.logicalDevice->createQueryPoolUnique(qpci);
+	this->scopeNames.assign(this->slots, {});
+}
+
+void gpu_profiler::reset(const vk::CommandBuffer& buffer, std::size_t slot) {
+	if (!isSupported()) {
+		return;
+	}
+
+	this->scopeNames[slot].clear();
+
+	buffer.resetQueryPool(this->queryPool.get(), firstQuery(slot), gpu_profiler::MAX_SCOPES * 2);
+}
+
+std::uint32_t gpu_profiler::begin(const vk::CommandBuffer& buffer, std::size_t slot, std::string_view name, vk::PipelineStageFlagBits stage) {
+	if (!isSupported() || this->scopeNames[slot].size() == gpu_profiler::MAX_SCOPES) {
+		return gpu_profiler::MAX_SCOPES;
+	}
+
+	const auto scope = static_cast<std::uint32_t>(this->scopeNames[slot].size());
+	this->scopeNames[slot].emplace_back(name);
+
+	buffer.writeTimestamp(stage, this->queryPool.get(), firstQuery(slot) + scope * 2);
+
+	return scope;
+}
+
+void gpu_profiler::end(const vk::CommandBuffer& buffer, std::size_t slot, std::uint32_t scope, vk::PipelineStageFlagBits stage) const {
+	if (!isSupported() || scope >= gpu_profiler::MAX_SCOPES) {
+		return;
+	}
+
+	buffer.writeTimestamp(stage, this->queryPool.get(), firstQuery(slot) + scope * 2 + 1);
+}
+
+void gpu_profiler::collect(std::size_t slot) {
+	if (!isSupported() || slot >= this->slots || this->scopeNames[slot].empty()) {
+		return;
+	}
+
+	const auto& names = this->scopeNames[slot];
+	const auto count = static_cast<std::uint32_t>(names.size() * 2);
+
+	// Value and availability word per query
+	std::vector<std::uint64_t> results(count * 2);
+
+	const auto res = this->engine.logicalDevice->getQueryPoolResults(this->queryPool.get(), firstQuery(slot), count,
+																	 results.size() * sizeof(std::uint64_t), results.data(), 2 * sizeof(std::uint64_t),
+																	 vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+	if (res != vk::Result::eSuccess && res != vk::Result::eNotReady) {
+		return;
+	}
+
+	auto& p = profiler::get();
+
+	for (std::size_t i = 0; i < names.size(); ++i) {
+		const auto startAvailable = results[i * 4 + 1] != 0;
+		const auto endAvailable = results[i * 4 + 3] != 0;
+
+		if (!startAvailable || !endAvailable) {
+			continue;
+		}
+
+		const auto startTicks = results[i * 4] & this->validMask;
+		const auto endTicks = results[i * 4 + 2] & this->validMask;
+		const auto ticks = (endTicks - startTicks) & this->validMask;
+
+		const auto startUs = static_cast<double>(startTicks) * this->nsPerTick / 1000.0;
+		const auto durationUs = static_cast<double>(ticks) * this->nsPerTick / 1000.0;
+
+		if (!this->offsetUs) {
+			this->offsetUs = p.toMicroseconds(profiler::clock::now()) - (startUs + durationUs);
+		}
+
+		p.record(profiler::track::gpu, names[i], startUs + this->offsetUs.value(), durationUs);
+	}
+}
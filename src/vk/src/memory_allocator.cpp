@@ -0,0 +1,239 @@
+#include "memory_allocator.h"
+
+#include <algorithm>
+#include <isdebug.h>
+#include <spdlog/spdlog.h>
+
+memory_allocator::allocation& memory_allocator::allocation::operator=(memory_allocator::allocation&& other) noexcept {
+	if (this != &other) {
+		reset();
+
+		this->allocator = std::exchange(other.allocator, nullptr);
+		this->owner = std::exchange(other.owner, nullptr);
+		this->memory = std::exchange(other.memory, vk::DeviceMemory());
+		this->memoryType = other.memoryType;
+		this->offset = other.offset;
+		this->size = other.size;
+		this->mapped = std::exchange(other.mapped, nullptr);
+	}
+
+	return *this;
+}
+
+void memory_allocator::allocation::reset() noexcept {
+	if (this->allocator) {
+		this->allocator->free(*this);
+		this->allocator = nullptr;
+		this->owner = nullptr;
+		this->memory = vk::DeviceMemory();
+		this->mapped = nullptr;
+	}
+}
+
+bool memory_allocator::allocation::isCoherent() const noexcept {
+	return this->allocator == nullptr || this->allocator->isCoherent(this->memoryType);
+}
+
+void memory_allocator::allocation::flush(vk::DeviceSize rangeOffset, vk::DeviceSize rangeSize) const {
+	if (!isCoherent()) {
+		this->allocator->device.flushMappedMemoryRanges(this->allocator->mappedRange(*this, rangeOffset, rangeSize));
+	}
+}
+
+void memory_allocator::allocation::invalidate(vk::DeviceSize rangeOffset, vk::DeviceSize rangeSize) const {
+	if (!isCoherent()) {
+		this->allocator->device.invalidateMappedMemoryRanges(this->allocator->mappedRange(*this, rangeOffset, rangeSize));
+	}
+}
+
+memory_allocator::memory_allocator(const vk::Device& device, const vk::PhysicalDeviceMemoryProperties& memoryProperties, vk::DeviceSize nonCoherentAtomSize, vk::DeviceSize blockSize) :
+	device(device), memoryProperties(memoryProperties), nonCoherentAtomSize(nonCoherentAtomSize), blockSize(blockSize) {
+}
+
+bool memory_allocator::isHostVisible(std::uint32_t memoryType) const noexcept {
+	return static_cast<bool>(this->memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible);
+}
+
+bool memory_allocator::isCoherent(std::uint32_t memoryType) const noexcept {
+	return static_cast<bool>(this->memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+}
+
+vk::MappedMemoryRange memory_allocator::mappedRange(const allocation& alloc, vk::DeviceSize rangeOffset, vk::DeviceSize rangeSize) const noexcept {
+	const auto atom = this->nonCoherentAtomSize;
+
+	const auto begin = alloc.offset + rangeOffset;
+	const auto end = rangeSize == VK_WHOLE_SIZE ? alloc.offset + alloc.size : std::min(begin + rangeSize, alloc.offset + alloc.size);
+
+	// Allocations in non-coherent types are atom aligned and sized, so rounding never leaves the allocation
+	const auto alignedBegin = begin / atom * atom;
+	const auto alignedEnd = std::min((end + atom - 1) / atom * atom, alloc.owner->size);
+
+	return vk::MappedMemoryRange {
+		alloc.memory,
+		alignedBegin,
+		alignedEnd - alignedBegin
+	};
+}
+
+std::optional<vk::DeviceSize> memory_allocator::carve(memory_allocator::block& b, const vk::MemoryRequirements& requirements) noexcept {
+	const auto alignment = std::max<vk::DeviceSize>(requirements.alignment, 1);
+
+	for (auto it = b.freeRanges.begin(); it != b.freeRanges.end(); ++it) {
+		const auto [rangeOffset, rangeSize] = *it;
+
+		const auto alignedOffset = (rangeOffset + alignment - 1) / alignment * alignment;
+		const auto padding = alignedOffset - rangeOffset;
+
+		if (padding + requirements.size > rangeSize) {
+			continue;
+		}
+
+		b.freeRanges.erase(it);
+
+		if (padding > 0) {
+			b.freeRanges.emplace(rangeOffset, padding);
+		}
+
+		const auto tail = rangeSize - padding - requirements.size;
+
+		if (tail > 0) {
+			b.freeRanges.emplace(alignedOffset + requirements.size, tail);
+		}
+
+		++b.allocations;
+
+		return alignedOffset;
+	}
+
+	return {};
+}
+
+memory_allocator::allocation memory_allocator::allocate(const vk::MemoryRequirements& memoryRequirements, std::uint32_t memoryType) {
+	std::scoped_lock lock(this->mutex);
+
+	auto requirements = memoryRequirements;
+
+	if (isHostVisible(memoryType) && !isCoherent(memoryType)) {
+		requirements.alignment = std::max(requirements.alignment, this->nonCoherentAtomSize);
+		requirements.size = (requirements.size + this->nonCoherentAtomSize - 1) / this->nonCoherentAtomSize * this->nonCoherentAtomSize;
+	}
+
+	auto& typeBlocks = this->blocks[memoryType];
+
+	allocation alloc;
+	alloc.allocator = this;
+	alloc.memoryType = memoryType;
+	alloc.size = requirements.size;
+
+	for (auto& b : typeBlocks) {
+		const auto offset = carve(*b, requirements);
+
+		if (offset) {
+			alloc.owner = b.get();
+			alloc.memory = b->memory.get();
+			alloc.offset = offset.value();
+			alloc.mapped = b->mapped ? static_cast<std::uint8_t*>(b->mapped) + alloc.offset : nullptr;
+			return alloc;
+		}
+	}
+
+	// Oversized requests get a block of their own instead of failing
+	const auto size = std::max(this->blockSize, requirements.size);
+
+	const vk::MemoryAllocateInfo mai {
+		size,
+		memoryType
+	};
+
+	auto newBlock = std::make_unique<block>(block{ this->device.allocateMemoryUnique(mai), size });
+	newBlock->freeRanges.emplace(0, size);
+
+	// Mapped once per block, every allocation carved from it gets a stable pointer
+	if (isHostVisible(memoryType)) {
+		newBlock->mapped = this->device.mapMemory(newBlock->memory.get(), 0, VK_WHOLE_SIZE);
+	}
+
+	if constexpr (com::isDebug) {
+		spdlog::get("graphics")->debug("New memory block: type {} size {}", memoryType, size);
+	}
+
+	alloc.owner = newBlock.get();
+	alloc.memory = newBlock->memory.get();
+	alloc.offset = carve(*newBlock, requirements).value();
+	alloc.mapped = newBlock->mapped ? static_cast<std::uint8_t*>(newBlock->mapped) + alloc.offset : nullptr;
+
+	typeBlocks.emplace_back(std::move(newBlock));
+
+	return alloc;
+}
+
+void memory_allocator::free(memory_allocator::allocation& alloc) noexcept {
+	std::scoped_lock lock(this->mutex);
+
+	auto& b = *alloc.owner;
+
+	auto [it, inserted] = b.freeRanges.emplace(alloc.offset, alloc.size);
+
+	const auto next = std::next(it);
+	if (next != b.freeRanges.end() && it->first + it->second == next->first) {
+		it->second += next->second;
+		b.freeRanges.erase(next);
+	}
+
+	if (it != b.freeRanges.begin()) {
+		const auto prev = std::prev(it);
+		if (prev->first + prev->second == it->first) {
+			prev->second += it->second;
+			b.freeRanges.erase(it);
+		}
+	}
+
+	--b.allocations;
+
+	if (b.allocations > 0) {
+		return;
+	}
+
+	// Keep one empty standard block per memory type around so that alloc/free churn doesn't hit the driver,
+	// dedicated blocks of oversized requests are released right away
+	auto& typeBlocks = this->blocks[alloc.memoryType];
+
+	const auto dedicated = b.size > this->blockSize;
+	const auto standardBlocks = std::count_if(typeBlocks.begin(), typeBlocks.end(), [this](const auto& candidate) { return candidate->size == this->blockSize; });
+
+	if (dedicated || standardBlocks > 1) {
+		std::erase_if(typeBlocks, [&b](const auto& candidate) { return candidate.get() == &b; });
+	}
+}
+
+memory_allocator::statistics memory_allocator::getStatistics() const {
+	std::scoped_lock lock(this->mutex);
+
+	statistics stats{};
+
+	for (const auto& typeBlocks : this->blocks) {
+		for (const auto& b : typeBlocks) {
+			++stats.blockCount;
+			stats.allocationCount += b->allocations;
+			stats.freeRangeCount += b->freeRanges.size();
+			stats.bytesReserved += b->size;
+
+			for (const auto& [offset, size] : b->freeRanges) {
+				stats.bytesFree += size;
+				stats.largestFreeRange = std::max(stats.largestFreeRange, size);
+			}
+		}
+	}
+
+	stats.bytesUsed = stats.bytesReserved - stats.bytesFree;
+
+	return stats;
+}
+
+void memory_allocator::logStatistics() const {
+	const auto stats = getStatistics();
+
+	spdlog::get("graphics")->info("Memory: {} blocks, {} allocations, {}/{} bytes used, {} free ranges (largest {}), fragmentation {:.2f}",
+								  stats.blockCount, stats.allocationCount, stats.bytesUsed, stats.bytesReserved,
+								  stats.freeRangeCount, stats.largestFreeRange, stats.fragmentation());
+}
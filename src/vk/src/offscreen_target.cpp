@@ -0,0 +1,109 @@
+#include "offscreen_target.h"
+
+offscreen_target::offscreen_target(const engine_vk& engine, const vk::Extent2D& extent, vk::Format format, std::size_t imageCount) : engine(engine), format(format), extent(extent) {
+	createImages(imageCount);
+}
+
+void offscreen_target::recreate() {
+	const auto imageCount = this->images.size();
+
+	// Pending readbacks still reference the old images, they are retired instead of waited on
+	this->engine.retire(std::move(this->readbackCmdBuffers));
+	this->engine.retire(std::move(this->readbackBuffers));
+	this->engine.retire(std::move(this->images));
+
+	createImages(imageCount);
+}
+
+void offscreen_target::createImages(std::size_t imageCount) {
+	this->readbackCmdBuffers.clear();
+	this->readbackValues.clear();
+	this->readbackBuffers.clear();
+	this->images.clear();
+
+	this->nextImage = 0;
+	this->lastPresented.reset();
+
+	this->readbackCmdBuffers = this->engine.allocateCmdBuffers(vk::QueueFlagBits::eGraphics, vk::CommandBufferLevel::ePrimary, imageCount);
+
+	for (std::size_t i = 0; i < imageCount; ++i) {
+		this->images.emplace_back(this->engine.createImage(this->extent, this->format, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc, engine_vk::memory_usage::device_local));
+		this->readbackBuffers.emplace_back(this->engine.createBuffer(imageBytes(), vk::BufferUsageFlagBits::eTransferDst, engine_vk::memory_usage::readback));
+		this->readbackValues.emplace_back(0);
+
+		recordReadback(i);
+	}
+}
+
+std::size_t offscreen_target::imageBytes() const noexcept {
+	return static_cast<std::size_t>(this->extent.width) * this->extent.height * offscreen_target::BYTES_PER_TEXEL;
+}
+
+void offscreen_target::recordReadback(std::size_t index) {
+	const auto& buffer = this->readbackCmdBuffers[index];
+
+	const vk::CommandBufferBeginInfo cbbi {};
+	buffer->begin(cbbi);
+
+	const vk::BufferImageCopy region {
+		0,
+		0,
+		0,
+		vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+		vk::Offset3D{ 0, 0, 0 },
+		vk::Extent3D{ this->extent.width, this->extent.height, 1 }
+	};
+
+	buffer->copyImageToBuffer(this->images[index].image.get(), vk::ImageLayout::eTransferSrcOptimal, this->readbackBuffers[index].buffer.get(), 1, &region);
+
+	const vk::BufferMemoryBarrier bmb {
+		vk::AccessFlagBits::eTransferWrite,
+		vk::AccessFlagBits::eHostRead,
+		VK_QUEUE_FAMILY_IGNORED,
+		VK_QUEUE_FAMILY_IGNORED,
+		this->readbackBuffers[index].buffer.get(),
+		0,
+		VK_WHOLE_SIZE
+	};
+
+	buffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, 0, nullptr, 1, &bmb, 0, nullptr);
+
+	buffer->end();
+}
+
+std::uint32_t offscreen_target::acquireNextImage(const vk::Semaphore& semaphore) {
+	const auto index = this->nextImage;
+	this->nextImage = static_cast<std::uint32_t>((index + 1) % this->images.size());
+
+	// Like a swapchain, block until the image's previous frame has been consumed
+	this->engine.waitTimeline(vk::QueueFlagBits::eGraphics, this->readbackValues[index]);
+
+	engine_vk::submission signal {};
+	signal.signalSemaphores = { semaphore };
+
+	static_cast<void>(this->engine.submit(vk::QueueFlagBits::eGraphics, { signal }));
+
+	return index;
+}
+
+vk::Result offscreen_target::present(const std::vector<vk::Semaphore>& waitSemaphores, std::uint32_t index) {
+	engine_vk::submission copy {};
+	copy.cmdBuffers = { this->readbackCmdBuffers[index].get() };
+	copy.waitSemaphores = waitSemaphores;
+	copy.waitStages.assign(waitSemaphores.size(), vk::PipelineStageFlagBits::eTransfer);
+
+	this->readbackValues[index] = this->engine.submit(vk::QueueFlagBits::eGraphics, { copy });
+	this->lastPresented = index;
+
+	// Always succeeds on purpose, offscreen images never go out of date or suboptimal and a failed submit throws
+	return vk::Result::eSuccess;
+}
+
+std::vector<std::uint8_t> offscreen_target::readback(std::uint32_t index) const {
+	this->engine.waitTimeline(vk::QueueFlagBits::eGraphics, this->readbackValues[index]);
+
+	std::vector<std::uint8_t> texels(imageBytes());
+	this->engine.copy(texels.data(), this->readbackBuffers[index], 0, 0, texels.size());
+
+	return texels;
+}
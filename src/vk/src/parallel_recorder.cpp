@@ -0,0 +1,50 @@
+#include "parallel_recorder.h"
+
+parallel_recorder::parallel_recorder(const engine_vk& engine, job_system& jobs, std::size_t frameSlots) : engine(engine), jobs(jobs) {
+	this->pools.resize(frameSlots);
+
+	for (auto& slot : this->pools) {
+		slot.reserve(this->jobs.getWorkerCount());
+
+		for (std::size_t i = 0; i < this->jobs.getWorkerCount(); ++i) {
+			slot.emplace_back(worker_pool{ this->engine.createCommandPool(vk::QueueFlagBits::eGraphics, vk::CommandPoolCreateFlagBits::eTransient) });
+		}
+	}
+}
+
+void parallel_recorder::beginFrame(std::size_t frameSlot) {
+	for (auto& workerPool : this->pools[frameSlot]) {
+		if (workerPool.used > 0) {
+			this->engine.resetCommandPool(workerPool.pool.get());
+			workerPool.used = 0;
+		}
+	}
+}
+
+std::vector<vk::CommandBuffer> parallel_recorder::record(std::size_t frameSlot, const vk::CommandBufferInheritanceInfo& cbii, std::size_t drawCount, const record_function& record) {
+	std::vector<vk::CommandBuffer> secondaries(std::min(drawCount, this->jobs.getWorkerCount()));
+
+	const vk::CommandBufferBeginInfo cbbi {
+		vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+		&cbii
+	};
+
+	this->jobs.parallelFor(drawCount, [this, frameSlot, &secondaries, &cbbi, &record](std::size_t worker, std::size_t slice, std::size_t begin, std::size_t end) {
+		auto& workerPool = this->pools[frameSlot][worker];
+
+		// A fast worker can pick up more than one slice, so pools grow on demand and keep their buffers across frames
+		if (workerPool.used == workerPool.buffers.size()) {
+			workerPool.buffers.emplace_back(std::move(this->engine.allocateCmdBuffers(workerPool.pool.get(), vk::CommandBufferLevel::eSecondary, 1)[0]));
+		}
+
+		const auto& buffer = workerPool.buffers[workerPool.used++].get();
+
+		buffer.begin(cbbi);
+		record(buffer, begin, end);
+		buffer.end();
+
+		secondaries[slice] = buffer;
+	});
+
+	return secondaries;
+}
@@ -2,6 +2,8 @@
 
 #include "vk_helper.h"
 
+#include <algorithm>
+
 pipeline::pipeline(const engine_vk &engine) : engine(engine) {
 	this->pdssci = {
 		{},
@@ -47,36 +49,181 @@ pipeline::pipeline(const engine_vk &engine) : engine(engine) {
 }
 
 void pipeline::addShader(const vk::ShaderStageFlagBits& type, const std::string &filename) noexcept {
-	auto shader = this->engine.createShaderModule(filename);
+	auto shader = this->engine.getShaderCache().get(filename);
 	const vk::SpecializationInfo *spPointer = nullptr;
 
 	vk::PipelineShaderStageCreateInfo pssci {
 		{},
 		type,
-		shader.get(),
+		shader->module.get(),
 		"main",
 		spPointer
 	};
 
 	this->shaderModules.emplace_back(type, std::move(shader));
 	this->shaderStages.emplace_back(pssci);
+	this->shaderNames.emplace_back(filename);
+}
+
+bool pipeline::usesShader(const std::string& name) const noexcept {
+	return std::find(this->shaderNames.begin(), this->shaderNames.end(), name) != this->shaderNames.end();
+}
+
+void pipeline::reloadShaders() {
+	// A rebuild of older sources is obsolete, waits for it and throws it away
+	this->pendingRebuild.reset();
+
+	auto next = std::make_unique<rebuild>();
+	next->stages = this->shaderStages;
+
+	bool changed = false;
+
+	for (std::size_t i = 0; i < this->shaderNames.size(); ++i) {
+		const auto& current = std::get<1>(this->shaderModules[i]);
+		auto shader = this->engine.getShaderCache().reload(this->shaderNames[i]);
+
+		// The layout and vertex input stay, a shader needing different ones takes a restart
+		if (!shader->reflection.sameInterface(current->reflection)) {
+			spdlog::get("graphics")->warn("Shader {} changed its interface, not reloaded", this->shaderNames[i]);
+			return;
+		}
+
+		changed = changed || shader != current;
+		next->stages[i].module = shader->module.get();
+		next->modules.emplace_back(std::move(shader));
+	}
+
+	if (!changed) {
+		return;
+	}
+
+	// Stages live in the heap allocated rebuild, moving the pointer into the member keeps them in place
+	next->result = std::async(std::launch::async, builder(next->stages));
+
+	this->pendingRebuild = std::move(next);
+}
+
+bool pipeline::swapRebuilt() {
+	if (!this->pendingRebuild || this->pendingRebuild->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+		return false;
+	}
+
+	const auto next = std::move(this->pendingRebuild);
+
+	vk::UniquePipeline rebuilt;
+
+	try {
+		rebuilt = next->result.get();
+	} catch (const vk::SystemError& error) {
+		spdlog::get("graphics")->warn("Pipeline rebuild failed, keeping the previous one: {}", error.what());
+		return false;
+	}
+
+	// Frames in flight finish with the previous pipeline, its modules aren't needed once it exists
+	this->engine.retire(std::move(this->pipeLine));
+	this->pipeLine = std::move(rebuilt);
+
+	for (std::size_t i = 0; i < this->shaderModules.size(); ++i) {
+		std::get<1>(this->shaderModules[i]) = std::move(next->modules[i]);
+	}
+
+	this->shaderStages = next->stages;
+
+	return true;
 }
 
-void pipeline::finalize(const renderpass& renderpass, const swapchain& swapchain) {
-	this->gpci.renderPass = renderpass.renderPass.get();
+void pipeline::finishRebuild() {
+	if (this->pendingRebuild) {
+		this->pendingRebuild->result.wait();
+		static_cast<void>(swapRebuilt());
+	}
+}
+
+void pipeline::finalize(const renderpass& renderpass, const render_target& target) {
+	finalize(renderpass.renderPass.get(), 0);
+}
+
+void pipeline::finalize(const vk::RenderPass& renderPass, std::uint32_t subpass) {
+	finishRebuild();
+
+	this->gpci.pNext = nullptr;
+	this->gpci.renderPass = renderPass;
+	this->gpci.subpass = subpass;
+
+	createPipeline();
+}
+
+void pipeline::finalize(const std::vector<vk::Format>& colorFormats, vk::Format depthFormat) {
+	finishRebuild();
+
+	this->renderingFormats = colorFormats;
+
+	this->prci = vk::PipelineRenderingCreateInfoKHR {
+		0,
+		static_cast<std::uint32_t>(this->renderingFormats.size()), this->renderingFormats.data(),
+		depthFormat
+	};
+
+	this->gpci.pNext = &this->prci;
+	this->gpci.renderPass = nullptr;
 	this->gpci.subpass = 0;
 
+	createPipeline();
+}
+
+void pipeline::createPipeline() {
 	this->gpci.stageCount = static_cast<std::uint32_t>(this->shaderStages.size());
 	this->gpci.pStages = this->shaderStages.data();
 
-	this->plci.setLayoutCount = 0;//static_cast<std::uint32_t>(this->descriptorLayoutSets.size());
-	this->plci.pSetLayouts = &this->descriptorLayout.get();//this->descriptorLayoutSets.data();
+	createLayout();
+
+	this->gpci.layout = this->pipeLineLayout.get();
+
+	this->pipeLine = builder(this->shaderStages)();
+}
+
+std::function<vk::UniquePipeline()> pipeline::builder(const std::vector<vk::PipelineShaderStageCreateInfo>& stages) const {
+	auto info = this->gpci;
+	info.stageCount = static_cast<std::uint32_t>(stages.size());
+	info.pStages = stages.data();
+
+	return [device = this->engine.logicalDevice.get(), cache = this->engine.pipelineCache.get(), info]() {
+		return device.createGraphicsPipelineUnique(cache, info).value;
+	};
+}
+
+void pipeline::createLayout() {
+	this->setLayouts.clear();
+
+	if (this->bindlessLayout) {
+		this->setLayouts.emplace_back(this->bindlessLayout);
+	}
+
+	if (this->descriptorLayout) {
+		this->setLayouts.emplace_back(this->descriptorLayout);
+	}
+
+	this->plci.setLayoutCount = static_cast<std::uint32_t>(this->setLayouts.size());
+	this->plci.pSetLayouts = this->setLayouts.data();
+
+	this->plci.pushConstantRangeCount = static_cast<std::uint32_t>(this->pushConstantRanges.size());
+	this->plci.pPushConstantRanges = this->pushConstantRanges.data();
+
+	// Re-finalizing while frames are in flight, they keep using the previous pipeline until they complete
+	if (this->pipeLine) {
+		this->engine.retire(std::move(this->pipeLine));
+		this->engine.retire(std::move(this->pipeLineLayout));
+	}
 
 	this->pipeLineLayout = this->engine.logicalDevice->createPipelineLayoutUnique(this->plci);
+}
 
-	this->gpci.layout = this->pipeLineLayout.get();
+void pipeline::addPushConstantRange(const vk::PushConstantRange& range) {
+	this->pushConstantRanges.emplace_back(range);
+}
 
-	this->pipeLine = this->engine.logicalDevice->createGraphicsPipelineUnique(vk::PipelineCache(), this->gpci).value;
+void pipeline::useBindless(const bindless_table& table) {
+	this->bindlessLayout = table.layout();
 }
 
 void pipeline::setViewPortScissor(const vk::Extent2D &size) {
@@ -90,14 +237,82 @@ void pipeline::setViewPortScissor(const vk::Extent2D &size) {
 }
 
 void pipeline::setDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& descriptorSetLayoutBindings) {
-	const vk::DescriptorSetLayoutCreateInfo dslci {
-		{},
-		static_cast<std::uint32_t>(descriptorSetLayoutBindings.size()),
-		descriptorSetLayoutBindings.data()
-	};
-	this->descriptorLayout = this->engine.logicalDevice->createDescriptorSetLayoutUnique(dslci);
-//	this->descriptorLayoutSets.emplace_back(*descriptorSet);
-//	this->descriptorLayoutSetsBuffer.emplace_back(std::move(descriptorSet));
+	this->descriptorBindings = descriptorSetLayoutBindings;
+	this->descriptorLayout = this->engine.getLayoutCache().get(descriptorSetLayoutBindings);
+}
+
+void pipeline::reflectLayout() {
+	// Set 0 belongs to the bindless table when there is one, the shaders declare it but the engine owns its layout
+	const std::uint32_t ownSet = this->bindlessLayout ? 1 : 0;
+
+	std::vector<vk::DescriptorSetLayoutBinding> bindings;
+
+	for (const auto& [stage, shader] : this->shaderModules) {
+		for (const auto& reflected : shader->reflection.getBindings()) {
+			if (this->bindlessLayout && reflected.set == 0) {
+				continue;
+			}
+
+			if (reflected.set != ownSet) {
+				spdlog::get("graphics")->error("Shader binding in set {}, pipelines only have set {}!", reflected.set, ownSet);
+				exit(EXIT_FAILURE);
+			}
+
+			// Only the bindless table sizes its arrays at runtime, an own set would get an empty binding
+			if (reflected.count == 0) {
+				spdlog::get("graphics")->error("Shader binding {} is a runtime sized array outside the bindless set!", reflected.binding);
+				exit(EXIT_FAILURE);
+			}
+
+			// Stages sharing a binding must agree on it, they are merged into one with both stage flags
+			const auto it = std::find_if(bindings.begin(), bindings.end(), [&reflected](const auto& b) { return b.binding == reflected.binding; });
+
+			if (it == bindings.end()) {
+				bindings.emplace_back(reflected.binding, reflected.type, reflected.count, stage);
+			} else if (it->descriptorType == reflected.type && it->descriptorCount == reflected.count) {
+				it->stageFlags |= stage;
+			} else {
+				spdlog::get("graphics")->error("Shader stages disagree on binding {}!", reflected.binding);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		if (const auto& range = shader->reflection.getPushConstants()) {
+			addPushConstantRange(vk::PushConstantRange{ stage, range->offset, range->size });
+		}
+	}
+
+	if (!bindings.empty()) {
+		setDescriptorSetLayout(bindings);
+	}
+}
+
+void pipeline::reflectVertexInput(std::uint32_t binding) {
+	const auto vertex = std::find_if(this->shaderModules.begin(), this->shaderModules.end(), [](const auto& module) {
+		return std::get<0>(module) == vk::ShaderStageFlagBits::eVertex;
+	});
+
+	this->vertexBindings.clear();
+	this->vertexAttributes.clear();
+
+	if (vertex != this->shaderModules.end()) {
+		std::uint32_t stride = 0;
+
+		for (const auto& input : std::get<1>(*vertex)->reflection.getInputs()) {
+			this->vertexAttributes.emplace_back(input.location, binding, input.format, stride);
+			stride += input.size;
+		}
+
+		if (!this->vertexAttributes.empty()) {
+			this->vertexBindings.emplace_back(binding, stride, vk::VertexInputRate::eVertex);
+		}
+	}
+
+	this->pvisci.vertexBindingDescriptionCount = static_cast<std::uint32_t>(this->vertexBindings.size());
+	this->pvisci.pVertexBindingDescriptions = this->vertexBindings.data();
+
+	this->pvisci.vertexAttributeDescriptionCount = static_cast<std::uint32_t>(this->vertexAttributes.size());
+	this->pvisci.pVertexAttributeDescriptions = this->vertexAttributes.data();
 }
 
 void pipeline::createDescriptorSetPool(const std::vector<vk::DescriptorPoolSize>& poolSizes, std::uint32_t maxSets) {
@@ -110,16 +325,48 @@ void pipeline::createDescriptorSetPool(const std::vector<vk::DescriptorPoolSize>
 	this->descriptorPool = this->engine.logicalDevice->createDescriptorPoolUnique(dpci);
 }
 
+void pipeline::createDescriptorSetPool(std::uint32_t maxSets) {
+	std::vector<vk::DescriptorPoolSize> poolSizes;
+
+	for (const auto& binding : this->descriptorBindings) {
+		const auto it = std::find_if(poolSizes.begin(), poolSizes.end(), [&binding](const auto& size) { return size.type == binding.descriptorType; });
+
+		if (it == poolSizes.end()) {
+			poolSizes.emplace_back(binding.descriptorType, binding.descriptorCount * maxSets);
+		} else {
+			it->descriptorCount += binding.descriptorCount * maxSets;
+		}
+	}
+
+	createDescriptorSetPool(poolSizes, maxSets);
+}
+
 void pipeline::bind(const vk::UniqueCommandBuffer& buffer, vk::PipelineBindPoint pipelineBindPoint) {
 	buffer->bindPipeline(pipelineBindPoint, this->pipeLine.get());
 }
 
+void pipeline::bind(const vk::CommandBuffer& buffer, vk::PipelineBindPoint pipelineBindPoint) const {
+	buffer.bindPipeline(pipelineBindPoint, this->pipeLine.get());
+}
+
 void pipeline::bindDescriptorSets(const vk::UniqueCommandBuffer& buffer, vk::PipelineBindPoint pipelineBindPoint, std::uint32_t firstSet, std::uint32_t descriptorSetCount, const vk::DescriptorSet* pDescriptorSets, std::uint32_t dynamicOffsetCount, const std::uint32_t* pDynamicOffsets) {
 	buffer->bindDescriptorSets(pipelineBindPoint, this->pipeLineLayout.get(), firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
 }
 
+void pipeline::bindDescriptorSets(const vk::CommandBuffer& buffer, vk::PipelineBindPoint pipelineBindPoint, std::uint32_t firstSet, std::uint32_t descriptorSetCount, const vk::DescriptorSet* pDescriptorSets) const {
+	buffer.bindDescriptorSets(pipelineBindPoint, this->pipeLineLayout.get(), firstSet, descriptorSetCount, pDescriptorSets, 0, nullptr);
+}
+
+void pipeline::pushConstants(const vk::CommandBuffer& buffer, const vk::ShaderStageFlags& stages, std::uint32_t offset, std::uint32_t size, const void* data) const {
+	buffer.pushConstants(this->pipeLineLayout.get(), stages, offset, size, data);
+}
+
+vk::UniqueDescriptorUpdateTemplate pipeline::createUpdateTemplate(const std::vector<vk::DescriptorUpdateTemplateEntry>& entries) const {
+	return this->engine.createUpdateTemplate(this->descriptorLayout, entries);
+}
+
 std::vector<vk::DescriptorSet> pipeline::getSets(std::uint32_t descriptorCount) {
-	std::vector<vk::DescriptorSetLayout> layouts(descriptorCount, this->descriptorLayout.get());
+	std::vector<vk::DescriptorSetLayout> layouts(descriptorCount, this->descriptorLayout);
 
 	const vk::DescriptorSetAllocateInfo dsai {
 			this->descriptorPool.get(),
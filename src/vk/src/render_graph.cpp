@@ -0,0 +1,706 @@
+#include "render_graph.h"
+
+#include <algorithm>
+#include <isdebug.h>
+#include <queue>
+#include <spdlog/spdlog.h>
+
+render_graph::pass& render_graph::pass::writeColor(const std::string& resource, std::optional<vk::ClearColorValue> clear) {
+	this->accesses.push_back({
+		resource,
+		vk::ImageLayout::eColorAttachmentOptimal,
+		vk::PipelineStageFlagBits::eColorAttachmentOutput,
+		vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite,
+		true,
+		attachment_kind::color,
+		clear ? std::optional<vk::ClearValue>(clear.value()) : std::nullopt
+	});
+
+	return *this;
+}
+
+render_graph::pass& render_graph::pass::writeDepth(const std::string& resource, std::optional<vk::ClearDepthStencilValue> clear) {
+	this->accesses.push_back({
+		resource,
+		vk::ImageLayout::eDepthStencilAttachmentOptimal,
+		vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+		vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+		true,
+		attachment_kind::depth,
+		clear ? std::optional<vk::ClearValue>(clear.value()) : std::nullopt
+	});
+
+	return *this;
+}
+
+render_graph::pass& render_graph::pass::readDepth(const std::string& resource) {
+	this->accesses.push_back({
+		resource,
+		vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+		vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+		vk::AccessFlagBits::eDepthStencilAttachmentRead,
+		false,
+		attachment_kind::depth,
+		{}
+	});
+
+	return *this;
+}
+
+render_graph::pass& render_graph::pass::sample(const std::string& resource, const vk::PipelineStageFlags& stages) {
+	this->accesses.push_back({ resource, vk::ImageLayout::eShaderReadOnlyOptimal, stages, vk::AccessFlagBits::eShaderRead, false, attachment_kind::none, {} });
+
+	return *this;
+}
+
+render_graph::pass& render_graph::pass::readStorage(const std::string& resource, const vk::PipelineStageFlags& stages) {
+	this->accesses.push_back({ resource, vk::ImageLayout::eGeneral, stages, vk::AccessFlagBits::eShaderRead, false, attachment_kind::none, {} });
+
+	return *this;
+}
+
+render_graph::pass& render_graph::pass::writeStorage(const std::string& resource, const vk::PipelineStageFlags& stages) {
+	this->accesses.push_back({ resource, vk::ImageLayout::eGeneral, stages, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite, true, attachment_kind::none, {} });
+
+	return *this;
+}
+
+void render_graph::createAttachment(const std::string& name, const attachment_info& info) {
+	this->resourceIds[name] = static_cast<resource_id>(this->resources.size());
+	this->resources.push_back({ name, info, false, false });
+}
+
+void render_graph::importImage(const std::string& name, const attachment_info& info, vk::ImageLayout initialLayout, vk::ImageLayout finalLayout) {
+	this->resourceIds[name] = static_cast<resource_id>(this->resources.size());
+
+	resource imported { name, info, true, false };
+	imported.initialLayout = initialLayout;
+	imported.finalLayout = finalLayout;
+
+	this->resources.emplace_back(std::move(imported));
+}
+
+void render_graph::setImage(const std::string& name, const vk::Image& image, const vk::ImageView& view) {
+	auto& r = this->resources[find(name)];
+
+	r.image = image;
+	r.view = view;
+}
+
+void render_graph::markOutput(const std::string& name) {
+	this->resources[find(name)].output = true;
+}
+
+render_graph::pass& render_graph::addGraphicsPass(const std::string& name) {
+	this->passes.push_back(pass(name, true));
+
+	return this->passes.back();
+}
+
+render_graph::pass& render_graph::addComputePass(const std::string& name) {
+	this->passes.push_back(pass(name, false));
+
+	return this->passes.back();
+}
+
+render_graph::resource_id render_graph::find(const std::string& name) const {
+	const auto it = this->resourceIds.find(name);
+
+	if (it == this->resourceIds.end()) {
+		spdlog::get("graphics")->error("Render graph resource {} was never declared!", name);
+		exit(EXIT_FAILURE);
+	}
+
+	return it->second;
+}
+
+std::vector<bool> render_graph::cullPasses() const {
+	std::vector<bool> alive(this->passes.size(), false);
+	std::vector<bool> needed(this->resources.size(), false);
+
+	for (std::size_t i = 0; i < this->resources.size(); ++i) {
+		needed[i] = this->resources[i].output;
+	}
+
+	// Walks back from the outputs until no further pass is found to contribute
+	for (bool changed = true; changed;) {
+		changed = false;
+
+		for (std::size_t p = 0; p < this->passes.size(); ++p) {
+			if (alive[p]) {
+				continue;
+			}
+
+			const auto& candidate = this->passes[p];
+
+			const auto contributes = candidate.sideEffects || std::any_of(candidate.accesses.begin(), candidate.accesses.end(), [this, &needed](const access& a) {
+				return a.write && needed[find(a.resource)];
+			});
+
+			if (!contributes) {
+				continue;
+			}
+
+			alive[p] = true;
+			changed = true;
+
+			// Attachments written without a clear are read too, their previous contents are loaded
+			for (const auto& a : candidate.accesses) {
+				if (!a.write || (a.attachment != attachment_kind::none && !a.clear)) {
+					needed[find(a.resource)] = true;
+				}
+			}
+		}
+	}
+
+	return alive;
+}
+
+std::vector<std::size_t> render_graph::sortPasses(const std::vector<bool>& alive) const {
+	const auto count = this->passes.size();
+
+	std::vector<std::vector<std::size_t>> successors(count);
+	std::vector<std::size_t> predecessors(count, 0);
+
+	const auto addEdge = [&successors, &predecessors](std::size_t from, std::size_t to) {
+		if (from != to && std::find(successors[from].begin(), successors[from].end(), to) == successors[from].end()) {
+			successors[from].emplace_back(to);
+			++predecessors[to];
+		}
+	};
+
+	// Declaration order defines which write a read sees, edges keep reads after that write and the next write after the reads
+	std::vector<std::optional<std::size_t>> lastWriter(this->resources.size());
+	std::vector<std::vector<std::size_t>> readers(this->resources.size());
+
+	for (std::size_t p = 0; p < count; ++p) {
+		if (!alive[p]) {
+			continue;
+		}
+
+		for (const auto& a : this->passes[p].accesses) {
+			const auto id = find(a.resource);
+
+			if (lastWriter[id]) {
+				addEdge(lastWriter[id].value(), p);
+			}
+
+			if (a.write) {
+				for (const auto reader : readers[id]) {
+					addEdge(reader, p);
+				}
+
+				readers[id].clear();
+				lastWriter[id] = p;
+			} else {
+				readers[id].emplace_back(p);
+			}
+		}
+	}
+
+	// Kahn's algorithm, ties go to the pass declared first
+	std::priority_queue<std::size_t, std::vector<std::size_t>, std::greater<>> ready;
+
+	for (std::size_t p = 0; p < count; ++p) {
+		if (alive[p] && predecessors[p] == 0) {
+			ready.push(p);
+		}
+	}
+
+	std::vector<std::size_t> order;
+
+	while (!ready.empty()) {
+		const auto p = ready.top();
+		ready.pop();
+
+		order.emplace_back(p);
+
+		for (const auto next : successors[p]) {
+			if (--predecessors[next] == 0) {
+				ready.push(next);
+			}
+		}
+	}
+
+	return order;
+}
+
+void render_graph::retireCompiled() {
+	for (auto& c : this->compiled) {
+		this->engine.retire(std::move(c.renderPass));
+		this->engine.retire(std::move(c.frameBuffers));
+	}
+
+	for (auto& r : this->resources) {
+		if (!r.imported) {
+			this->engine.retire(std::move(r.ownedView));
+			this->engine.retire(std::move(r.ownedImage));
+			r.image = vk::Image();
+			r.view = vk::ImageView();
+			r.bucket.reset();
+		}
+
+		r.usage = {};
+	}
+
+	// Queued after the images, so the memory is only returned once they are gone
+	for (auto& b : this->buckets) {
+		this->engine.retire(std::move(b.memory));
+	}
+
+	this->compiled.clear();
+	this->buckets.clear();
+	this->finalBarriers.clear();
+	this->finalResources.clear();
+	this->stats = {};
+}
+
+void render_graph::compile() {
+	retireCompiled();
+
+	const auto alive = cullPasses();
+	const auto order = sortPasses(alive);
+
+	// The framebuffer and render area are sized after the first attachment
+	for (const auto index : order) {
+		const auto& p = this->passes[index];
+
+		if (p.graphics && std::none_of(p.accesses.begin(), p.accesses.end(), [](const access& a) { return a.attachment != attachment_kind::none; })) {
+			spdlog::get("graphics")->error("Render graph graphics pass {} has no attachments!", p.name);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	this->stats.passes = order.size();
+	this->stats.culledPasses = this->passes.size() - order.size();
+
+	std::vector<bool> used(this->resources.size(), false);
+
+	for (std::size_t position = 0; position < order.size(); ++position) {
+		for (const auto& a : this->passes[order[position]].accesses) {
+			const auto id = find(a.resource);
+			auto& r = this->resources[id];
+
+			if (!used[id]) {
+				r.firstUse = position;
+				used[id] = true;
+			}
+
+			r.lastUse = position;
+
+			switch (a.attachment) {
+				case attachment_kind::color: r.usage |= vk::ImageUsageFlagBits::eColorAttachment; break;
+				case attachment_kind::depth: r.usage |= vk::ImageUsageFlagBits::eDepthStencilAttachment; break;
+				case attachment_kind::none: r.usage |= a.layout == vk::ImageLayout::eGeneral ? vk::ImageUsageFlagBits::eStorage : vk::ImageUsageFlagBits::eSampled; break;
+			}
+		}
+	}
+
+	// Transients no surviving pass touches never get an image
+	for (std::size_t i = 0; i < this->resources.size(); ++i) {
+		if (!used[i]) {
+			this->resources[i].usage = {};
+		}
+	}
+
+	allocateTransients();
+	computeBarriers(order);
+
+	for (std::size_t position = 0; position < order.size(); ++position) {
+		if (this->passes[order[position]].graphics) {
+			createRenderPass(this->compiled[position], order, position);
+		}
+	}
+
+	if constexpr (com::isDebug) {
+		spdlog::get("graphics")->debug("Render graph: {} passes ({} culled), {} barriers, {} transient bytes ({} without aliasing)",
+									   this->stats.passes, this->stats.culledPasses, this->stats.barriers, this->stats.transientBytes, this->stats.unaliasedBytes);
+	}
+}
+
+void render_graph::allocateTransients() {
+	std::vector<resource_id> transients;
+
+	const auto granularity = this->engine.getCapabilities().limits().bufferImageGranularity;
+
+	for (resource_id id = 0; id < this->resources.size(); ++id) {
+		auto& r = this->resources[id];
+
+		if (r.imported || !r.usage) {
+			continue;
+		}
+
+		const vk::ImageCreateInfo ici {
+			{},
+			vk::ImageType::e2D,
+			r.info.format,
+			vk::Extent3D{ r.info.extent.width, r.info.extent.height, 1 },
+			1,
+			1,
+			vk::SampleCountFlagBits::e1,
+			vk::ImageTiling::eOptimal,
+			r.usage,
+			vk::SharingMode::eExclusive
+		};
+
+		r.ownedImage = this->engine.logicalDevice->createImageUnique(ici);
+		r.image = r.ownedImage.get();
+		r.requirements = this->engine.logicalDevice->getImageMemoryRequirements(r.image);
+		r.requirements.alignment = std::max(r.requirements.alignment, granularity);
+		r.requirements.size = (r.requirements.size + granularity - 1) / granularity * granularity;
+
+		this->stats.unaliasedBytes += r.requirements.size;
+
+		transients.emplace_back(id);
+	}
+
+	// Largest first, each transient joins the first bucket whose members are all dead by the time it is needed
+	std::sort(transients.begin(), transients.end(), [this](resource_id a, resource_id b) {
+		return this->resources[a].requirements.size > this->resources[b].requirements.size;
+	});
+
+	for (const auto id : transients) {
+		auto& r = this->resources[id];
+
+		const auto fits = [this, &r](const memory_bucket& b) {
+			if (!(b.requirements.memoryTypeBits & r.requirements.memoryTypeBits)) {
+				return false;
+			}
+
+			return std::none_of(b.members.begin(), b.members.end(), [this, &r](resource_id member) {
+				const auto& other = this->resources[member];
+				return r.firstUse <= other.lastUse && other.firstUse <= r.lastUse;
+			});
+		};
+
+		auto bucket = std::find_if(this->buckets.begin(), this->buckets.end(), fits);
+
+		if (bucket == this->buckets.end()) {
+			this->buckets.push_back({ {}, r.requirements });
+			bucket = std::prev(this->buckets.end());
+		} else {
+			bucket->requirements.size = std::max(bucket->requirements.size, r.requirements.size);
+			bucket->requirements.alignment = std::max(bucket->requirements.alignment, r.requirements.alignment);
+			bucket->requirements.memoryTypeBits &= r.requirements.memoryTypeBits;
+		}
+
+		r.bucket = static_cast<std::size_t>(std::distance(this->buckets.begin(), bucket));
+		bucket->members.emplace_back(id);
+	}
+
+	for (auto& b : this->buckets) {
+		b.memory = this->engine.allocator->allocate(b.requirements, this->engine.memoryType(b.requirements.memoryTypeBits, engine_vk::memory_usage::device_local));
+		this->stats.transientBytes += b.requirements.size;
+
+		for (const auto id : b.members) {
+			auto& r = this->resources[id];
+
+			this->engine.logicalDevice->bindImageMemory(r.image, b.memory.getMemory(), b.memory.getOffset());
+
+			const vk::ImageViewCreateInfo ivci {
+				{},
+				r.image,
+				vk::ImageViewType::e2D,
+				r.info.format,
+				{},
+				vk::ImageSubresourceRange{ r.info.aspect, 0, 1, 0, 1 }
+			};
+
+			r.ownedView = this->engine.logicalDevice->createImageViewUnique(ivci);
+			r.view = r.ownedView.get();
+		}
+	}
+}
+
+void render_graph::computeBarriers(const std::vector<std::size_t>& order) {
+	struct state {
+		vk::ImageLayout layout;
+		vk::PipelineStageFlags writeStages;
+		vk::AccessFlags writeAccess;
+		vk::PipelineStageFlags readStages; // Already synchronized with the last write
+	};
+
+	constexpr auto writeMask = vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite
+		| vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eMemoryWrite;
+
+	// Every stage a resource is used in during a frame, the next frame's or the next alias's first use waits on them
+	std::vector<vk::PipelineStageFlags> frameStages(this->resources.size());
+	std::vector<vk::AccessFlags> frameWrites(this->resources.size());
+
+	for (const auto p : order) {
+		for (const auto& a : this->passes[p].accesses) {
+			const auto id = find(a.resource);
+			frameStages[id] |= a.stages;
+			frameWrites[id] |= a.accessMask & writeMask;
+		}
+	}
+
+	std::vector<state> states(this->resources.size());
+
+	for (resource_id id = 0; id < this->resources.size(); ++id) {
+		const auto& r = this->resources[id];
+
+		if (r.imported) {
+			states[id] = { r.initialLayout, vk::PipelineStageFlagBits::eAllCommands, vk::AccessFlagBits::eMemoryWrite, {} };
+			continue;
+		}
+
+		if (!r.bucket) {
+			continue;
+		}
+
+		// The alias that last used the memory before this one, wrapping around to the previous frame
+		const auto& members = this->buckets[r.bucket.value()].members;
+
+		const auto latest = [this, &members](auto&& eligible) {
+			std::optional<resource_id> found;
+
+			for (const auto member : members) {
+				if (eligible(this->resources[member]) && (!found || this->resources[member].lastUse > this->resources[found.value()].lastUse)) {
+					found = member;
+				}
+			}
+
+			return found;
+		};
+
+		const auto previous = latest([&r](const resource& other) { return other.lastUse < r.firstUse; })
+			.value_or(latest([](const resource&) { return true; }).value());
+
+		states[id] = { vk::ImageLayout::eUndefined, frameStages[previous], frameWrites[previous], {} };
+	}
+
+	const auto barrier = [this](compiled_pass& target, resource_id id, const state& from, vk::AccessFlags srcAccess, vk::ImageLayout layout, vk::AccessFlags dstAccess) {
+		const auto& r = this->resources[id];
+
+		target.barriers.emplace_back(
+			srcAccess,
+			dstAccess,
+			from.layout,
+			layout,
+			VK_QUEUE_FAMILY_IGNORED,
+			VK_QUEUE_FAMILY_IGNORED,
+			r.image,
+			vk::ImageSubresourceRange{ r.info.aspect, 0, 1, 0, 1 }
+		);
+
+		target.barrierResources.emplace_back(id);
+		++this->stats.barriers;
+	};
+
+	this->compiled.resize(order.size());
+
+	for (std::size_t position = 0; position < order.size(); ++position) {
+		auto& target = this->compiled[position];
+		target.passIndex = order[position];
+
+		for (const auto& a : this->passes[order[position]].accesses) {
+			const auto id = find(a.resource);
+			auto& s = states[id];
+
+			if (a.write || a.layout != s.layout) {
+				// Reads since the last write only need an execution dependency, otherwise the write has to be made available
+				const auto afterReads = static_cast<bool>(s.readStages);
+				const auto srcStages = afterReads ? s.readStages : s.writeStages;
+
+				barrier(target, id, s, afterReads ? vk::AccessFlags{} : s.writeAccess, a.layout, a.accessMask);
+
+				target.srcStages |= srcStages;
+				target.dstStages |= a.stages;
+
+				s.layout = a.layout;
+				s.writeStages = a.write ? a.stages : srcStages | a.stages;
+				s.writeAccess = a.write ? a.accessMask & writeMask : s.writeAccess;
+				s.readStages = a.write ? vk::PipelineStageFlags{} : a.stages;
+			} else if (a.stages & ~s.readStages) {
+				barrier(target, id, s, s.writeAccess, a.layout, a.accessMask);
+
+				target.srcStages |= s.writeStages;
+				target.dstStages |= a.stages;
+
+				s.readStages |= a.stages;
+			}
+		}
+
+		if (!target.srcStages) {
+			target.srcStages = vk::PipelineStageFlagBits::eTopOfPipe;
+		}
+	}
+
+	for (resource_id id = 0; id < this->resources.size(); ++id) {
+		const auto& r = this->resources[id];
+		const auto& s = states[id];
+
+		if (!r.imported || r.finalLayout == vk::ImageLayout::eUndefined || r.finalLayout == s.layout) {
+			continue;
+		}
+
+		this->finalBarriers.emplace_back(
+			s.writeAccess,
+			vk::AccessFlagBits::eMemoryRead,
+			s.layout,
+			r.finalLayout,
+			VK_QUEUE_FAMILY_IGNORED,
+			VK_QUEUE_FAMILY_IGNORED,
+			r.image,
+			vk::ImageSubresourceRange{ r.info.aspect, 0, 1, 0, 1 }
+		);
+
+		this->finalResources.emplace_back(id);
+		this->finalSrcStages |= s.writeStages | s.readStages;
+		++this->stats.barriers;
+	}
+}
+
+void render_graph::createRenderPass(compiled_pass& target, const std::vector<std::size_t>& order, std::size_t position) {
+	const auto& graphicsPass = this->passes[order[position]];
+
+	std::vector<vk::AttachmentDescription> descriptions;
+	std::vector<vk::AttachmentReference> colorRefs;
+	std::optional<vk::AttachmentReference> depthRef;
+
+	for (const auto& a : graphicsPass.accesses) {
+		if (a.attachment == attachment_kind::none) {
+			continue;
+		}
+
+		const auto id = find(a.resource);
+		const auto& r = this->resources[id];
+
+		// Contents only matter when an earlier pass wrote them and only have to reach memory when a later pass reads them
+		const auto writtenBefore = (r.imported && r.initialLayout != vk::ImageLayout::eUndefined) || std::any_of(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(position), [this, id](std::size_t p) {
+			const auto& accesses = this->passes[p].accesses;
+			return std::any_of(accesses.begin(), accesses.end(), [this, id](const access& other) { return other.write && find(other.resource) == id; });
+		});
+		const auto readAfter = r.imported || r.output || r.lastUse > position;
+
+		const auto loadOp = a.clear ? vk::AttachmentLoadOp::eClear : writtenBefore ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eDontCare;
+		const auto storeOp = readAfter ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+
+		const auto index = static_cast<std::uint32_t>(descriptions.size());
+
+		descriptions.emplace_back(
+			vk::AttachmentDescriptionFlags{},
+			r.info.format,
+			vk::SampleCountFlagBits::e1,
+			loadOp,
+			storeOp,
+			loadOp,
+			storeOp,
+			a.layout,
+			a.layout
+		);
+
+		if (a.attachment == attachment_kind::color) {
+			colorRefs.emplace_back(index, a.layout);
+		} else {
+			depthRef = vk::AttachmentReference{ index, a.layout };
+		}
+
+		target.attachments.emplace_back(id);
+		target.clearValues.emplace_back(a.clear.value_or(vk::ClearValue{}));
+	}
+
+	const vk::SubpassDescription subpass {
+		{},
+		vk::PipelineBindPoint::eGraphics,
+		0, nullptr,
+		static_cast<std::uint32_t>(colorRefs.size()), colorRefs.data(),
+		nullptr,
+		depthRef ? &depthRef.value() : nullptr,
+		0, nullptr
+	};
+
+	// The graph's barriers around the pass do the synchronization, layouts never change inside it
+	const vk::RenderPassCreateInfo rpci {
+		{},
+		static_cast<std::uint32_t>(descriptions.size()), descriptions.data(),
+		1, &subpass,
+		0, nullptr
+	};
+
+	target.renderPass = this->engine.logicalDevice->createRenderPassUnique(rpci);
+}
+
+void render_graph::execute(const vk::CommandBuffer& buffer) {
+	for (auto& c : this->compiled) {
+		const auto& current = this->passes[c.passIndex];
+
+		if (!c.barriers.empty()) {
+			for (std::size_t i = 0; i < c.barriers.size(); ++i) {
+				c.barriers[i].image = this->resources[c.barrierResources[i]].image;
+			}
+
+			buffer.pipelineBarrier(c.srcStages, c.dstStages, {}, 0, nullptr, 0, nullptr, static_cast<std::uint32_t>(c.barriers.size()), c.barriers.data());
+		}
+
+		if (!current.graphics) {
+			if (current.record) {
+				current.record(buffer);
+			}
+			continue;
+		}
+
+		std::vector<vk::ImageView> views;
+		views.reserve(c.attachments.size());
+
+		for (const auto id : c.attachments) {
+			views.emplace_back(this->resources[id].view);
+		}
+
+		const auto& extent = this->resources[c.attachments.front()].info.extent;
+		auto& frameBuffer = c.frameBuffers[views];
+
+		if (!frameBuffer) {
+			const vk::FramebufferCreateInfo fbci {
+				{},
+				c.renderPass.get(),
+				static_cast<std::uint32_t>(views.size()), views.data(),
+				extent.width,
+				extent.height,
+				1
+			};
+
+			frameBuffer = this->engine.logicalDevice->createFramebufferUnique(fbci);
+		}
+
+		const vk::RenderPassBeginInfo rpbi {
+			c.renderPass.get(),
+			frameBuffer.get(),
+			vk::Rect2D{ vk::Offset2D{ 0, 0 }, extent },
+			static_cast<std::uint32_t>(c.clearValues.size()), c.clearValues.data()
+		};
+
+		buffer.beginRenderPass(rpbi, vk::SubpassContents::eInline);
+
+		if (current.record) {
+			current.record(buffer);
+		}
+
+		buffer.endRenderPass();
+	}
+
+	if (!this->finalBarriers.empty()) {
+		for (std::size_t i = 0; i < this->finalBarriers.size(); ++i) {
+			this->finalBarriers[i].image = this->resources[this->finalResources[i]].image;
+		}
+
+		buffer.pipelineBarrier(this->finalSrcStages, vk::PipelineStageFlagBits::eBottomOfPipe, {}, 0, nullptr, 0, nullptr,
+							   static_cast<std::uint32_t>(this->finalBarriers.size()), this->finalBarriers.data());
+	}
+}
+
+vk::RenderPass render_graph::getRenderPass(const std::string& passName) const {
+	for (const auto& c : this->compiled) {
+		if (this->passes[c.passIndex].name == passName && c.renderPass) {
+			return c.renderPass.get();
+		}
+	}
+
+	spdlog::get("graphics")->error("Render graph pass {} has no render pass, it is unknown, culled or compute!", passName);
+	exit(EXIT_FAILURE);
+}
+
+vk::ImageView render_graph::getView(const std::string& name) const {
+	return this->resources[find(name)].view;
+}
@@ -1,103 +1,222 @@
 #include "renderpass.h"
 
-renderpass::renderpass(const engine_vk& engine, const class swapchain& swapchain) : engine(engine), swapChain(swapchain) {
+#include <algorithm>
+
+renderpass::renderpass(const engine_vk& engine, const render_target& target) : renderpass(engine, target, {}, { subpass_info{ { 0 } } }) {
+}
+
+renderpass::renderpass(const engine_vk& engine, const render_target& target, std::vector<transient_attachment> transientAttachments, const std::vector<subpass_info>& subpassInfos) :
+	engine(engine), target(target), transients(std::move(transientAttachments)) {
 
 	const vk::AttachmentDescription color {
 		{},
-		this->swapChain.format.format,
+		this->target.getFormat(),
 		vk::SampleCountFlagBits::e1,
 		vk::AttachmentLoadOp::eClear,
 		vk::AttachmentStoreOp::eStore,
 		vk::AttachmentLoadOp::eDontCare,
 		vk::AttachmentStoreOp::eDontCare,
 		vk::ImageLayout::eUndefined,
-		vk::ImageLayout::ePresentSrcKHR
+		this->target.getFinalLayout()
 	};
 
 	this->colorAttachements = { color };
+	this->renderPassAttachements = this->colorAttachements;
 
-	//	const auto index = static_cast<std::uint32_t>(this->renderPassAttachements.size());
-	for(std::size_t i = 0; i < this->colorAttachements.size(); ++i) {
-		this->colorAttachementRefs.emplace_back(static_cast<std::uint32_t>(i), vk::ImageLayout::eColorAttachmentOptimal);
-		this->renderPassAttachements.push_back(this->colorAttachements[i]);
-	}
+	describe(subpassInfos);
 
-	const vk::SubpassDescription subpass0 {
-		{},
-		vk::PipelineBindPoint::eGraphics,
-		0,nullptr,
-		1, &this->colorAttachementRefs[0],
-		nullptr,
-		nullptr,
-		0, nullptr,
+	this->rpci.attachmentCount = static_cast<std::uint32_t>(this->renderPassAttachements.size());
+	this->rpci.pAttachments = this->renderPassAttachements.data();
+
+	this->rpci.subpassCount = static_cast<std::uint32_t>(this->subpasses.size());
+	this->rpci.pSubpasses = this->subpasses.data();
+
+	this->rpci.dependencyCount = static_cast<std::uint32_t>(this->dependencies.size());
+	this->rpci.pDependencies = this->dependencies.data();
+
+	createPassAndFrameBuffers();
+}
+
+void renderpass::describe(const std::vector<subpass_info>& subpassInfos) {
+	const auto isDepth = [this](std::uint32_t attachment) {
+		return attachment > 0 && static_cast<bool>(this->transients[attachment - 1].aspect & vk::ImageAspectFlagBits::eDepth);
 	};
 
-	const vk::SubpassDescription subpass1 {
-        {},
-        vk::PipelineBindPoint::eGraphics,
-        0,nullptr,
-        1, &this->colorAttachementRefs[0],
-        nullptr,
-        nullptr,
-        0, nullptr,
+	const auto readAsInput = [&subpassInfos](std::uint32_t attachment) {
+		return std::any_of(subpassInfos.begin(), subpassInfos.end(), [attachment](const subpass_info& info) {
+			return std::find(info.inputs.begin(), info.inputs.end(), attachment) != info.inputs.end();
+		});
 	};
 
-	this->subpasses.emplace_back(subpass0);
-	//this->subpasses.emplace_back(subpass1);
+	// Cleared on load and dropped on store, on tilers they never touch memory
+	for (std::uint32_t i = 0; i < this->transients.size(); ++i) {
+		const auto attachment = i + 1;
+		const auto depth = isDepth(attachment);
+		const auto input = readAsInput(attachment);
+		const auto stencil = static_cast<bool>(this->transients[i].aspect & vk::ImageAspectFlagBits::eStencil);
+
+		this->renderPassAttachements.emplace_back(
+			vk::AttachmentDescriptionFlags{},
+			this->transients[i].format,
+			vk::SampleCountFlagBits::e1,
+			vk::AttachmentLoadOp::eClear,
+			vk::AttachmentStoreOp::eDontCare,
+			stencil ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eDontCare,
+			vk::AttachmentStoreOp::eDontCare,
+			vk::ImageLayout::eUndefined,
+			input ? vk::ImageLayout::eShaderReadOnlyOptimal : depth ? vk::ImageLayout::eDepthStencilAttachmentOptimal : vk::ImageLayout::eColorAttachmentOptimal
+		);
+
+		auto usage = depth ? vk::ImageUsageFlagBits::eDepthStencilAttachment : vk::ImageUsageFlagBits::eColorAttachment;
+		this->transientUsage.emplace_back(vk::ImageUsageFlagBits::eTransientAttachment | usage | (input ? vk::ImageUsageFlagBits::eInputAttachment : vk::ImageUsageFlags{}));
+	}
+
+	// Descriptions point into the references, so they are all created first
+	this->subpassRefs.resize(subpassInfos.size());
+
+	for (std::size_t i = 0; i < subpassInfos.size(); ++i) {
+		auto& refs = this->subpassRefs[i];
+
+		for (const auto attachment : subpassInfos[i].colors) {
+			refs.colors.emplace_back(attachment, vk::ImageLayout::eColorAttachmentOptimal);
+		}
+
+		for (const auto attachment : subpassInfos[i].inputs) {
+			refs.inputs.emplace_back(attachment, vk::ImageLayout::eShaderReadOnlyOptimal);
+		}
+
+		if (subpassInfos[i].depth) {
+			refs.depth = vk::AttachmentReference{ subpassInfos[i].depth.value(), vk::ImageLayout::eDepthStencilAttachmentOptimal };
+		}
+	}
+
+	for (const auto& refs : this->subpassRefs) {
+		this->subpasses.emplace_back(
+			vk::SubpassDescriptionFlags{},
+			vk::PipelineBindPoint::eGraphics,
+			static_cast<std::uint32_t>(refs.inputs.size()), refs.inputs.data(),
+			static_cast<std::uint32_t>(refs.colors.size()), refs.colors.data(),
+			nullptr,
+			refs.depth ? &refs.depth.value() : nullptr,
+			0, nullptr
+		);
+	}
+
+	constexpr auto depthStages = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
 
 	const vk::SubpassDependency dependency_imageAcquire {
 		VK_SUBPASS_EXTERNAL,
 		0,
 		vk::PipelineStageFlagBits::eBottomOfPipe,
-		vk::PipelineStageFlagBits::eColorAttachmentOutput,
+		vk::PipelineStageFlagBits::eColorAttachmentOutput | (this->transients.empty() ? vk::PipelineStageFlags{} : depthStages),
 		vk::AccessFlagBits::eMemoryRead,
-		vk::AccessFlagBits::eColorAttachmentWrite,
+		vk::AccessFlagBits::eColorAttachmentWrite | (this->transients.empty() ? vk::AccessFlags{} : vk::AccessFlagBits::eDepthStencilAttachmentWrite),
 		{}
 	};
 
-//	const vk::SubpassDependency dependency_subpass0Finished {
-//		0,
-//		1,
-//		vk::PipelineStageFlagBits::eColorAttachmentOutput,
-//		vk::PipelineStageFlagBits::eColorAttachmentOutput,
-//		{},
-//		vk::AccessFlagBits::eColorAttachmentWrite,
-//		{}
-//	};
+	this->dependencies = { dependency_imageAcquire };
 
-	this->dependencies = { dependency_imageAcquire };//, dependency_subpass0Finished };
+	// By region: each subpass only reads the fragment the previous one wrote at the same position, so tiles never leave the chip
+	for (std::uint32_t dst = 1; dst < subpassInfos.size(); ++dst) {
+		const auto& reads = subpassInfos[dst];
 
-	this->rpci.attachmentCount = static_cast<std::uint32_t>(this->renderPassAttachements.size());
-	this->rpci.pAttachments = this->renderPassAttachements.data();
+		for (std::uint32_t src = 0; src < dst; ++src) {
+			const auto& writes = subpassInfos[src];
 
-	this->rpci.subpassCount = static_cast<std::uint32_t>(this->subpasses.size());
-	this->rpci.pSubpasses = this->subpasses.data();
+			const auto written = [&writes](std::uint32_t attachment) {
+				return std::find(writes.colors.begin(), writes.colors.end(), attachment) != writes.colors.end() || writes.depth == attachment;
+			};
 
-	this->rpci.dependencyCount = static_cast<std::uint32_t>(this->dependencies.size());
-	this->rpci.pDependencies = this->dependencies.data();
+			const auto inputs = std::any_of(reads.inputs.begin(), reads.inputs.end(), written);
+			const auto colors = std::any_of(reads.colors.begin(), reads.colors.end(), written);
+			const auto depth = reads.depth && written(reads.depth.value());
 
-	createPassAndFrameBuffers();
+			if (!inputs && !colors && !depth) {
+				continue;
+			}
+
+			vk::SubpassDependency dependency {
+				src,
+				dst,
+				vk::PipelineStageFlagBits::eColorAttachmentOutput | (writes.depth ? vk::PipelineStageFlags(depthStages) : vk::PipelineStageFlags{}),
+				{},
+				vk::AccessFlagBits::eColorAttachmentWrite | (writes.depth ? vk::AccessFlags(vk::AccessFlagBits::eDepthStencilAttachmentWrite) : vk::AccessFlags{}),
+				{},
+				vk::DependencyFlagBits::eByRegion
+			};
+
+			if (inputs) {
+				dependency.dstStageMask |= vk::PipelineStageFlagBits::eFragmentShader;
+				dependency.dstAccessMask |= vk::AccessFlagBits::eInputAttachmentRead;
+			}
+
+			if (colors) {
+				dependency.dstStageMask |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
+				dependency.dstAccessMask |= vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+			}
+
+			if (depth) {
+				dependency.dstStageMask |= depthStages;
+				dependency.dstAccessMask |= vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+			}
+
+			this->dependencies.emplace_back(dependency);
+		}
+	}
 }
 
-void renderpass::updateFormat() noexcept {
-	this->colorAttachements[0].format = this->swapChain.format.format;
+bool renderpass::updateFormat() noexcept {
+	if (this->colorAttachements[0].format == this->target.getFormat()) {
+		return false;
+	}
+
+	this->colorAttachements[0].format = this->target.getFormat();
+	this->renderPassAttachements[0].format = this->target.getFormat();
+
+	return true;
 }
 
 void renderpass::createPassAndFrameBuffers() {
+	createPass();
+	createFrameBuffers();
+}
+
+void renderpass::createPass() {
+	if (this->renderPass) {
+		this->engine.retire(std::move(this->renderPass));
+	}
+
 	this->renderPass = this->engine.logicalDevice->createRenderPassUnique(rpci);
+}
+
+void renderpass::createFrameBuffers() {
+	if (!this->frameBuffers.empty()) {
+		this->engine.retire(std::move(this->frameBuffers));
+		this->engine.retire(std::move(this->transientImages));
+	}
+
+	this->frameBuffers.clear();
+	this->frameBuffers.resize(this->target.getNumImages());
+	this->transientImages.clear();
+	this->transientImages.resize(this->target.getNumImages());
 
-	this->frameBuffers.resize(this->swapChain.swapChainImages.size());
+	for (std::size_t i = 0; i < this->target.getNumImages(); ++i) {
+		std::vector fbAttachments{ this->target.getImageView(i) };
 
-	for (std::size_t i = 0; i < this->swapChain.swapChainImages.size(); ++i) {
-		std::vector fbAttachments{ this->swapChain.swapChainImageViews[i].get() };
+		for (std::size_t t = 0; t < this->transients.size(); ++t) {
+			const auto& transient = this->transients[t];
+
+			auto& image = this->transientImages[i].emplace_back(this->engine.createImage(this->target.getExtent(), transient.format, this->transientUsage[t], engine_vk::memory_usage::transient, transient.aspect));
+			fbAttachments.emplace_back(image.view.get());
+		}
 
 		vk::FramebufferCreateInfo fbci {
 				{},
 				this->renderPass.get(),
 				static_cast<std::uint32_t>(fbAttachments.size()),
 				fbAttachments.data(),
-				this->swapChain.extent.width,
-				this->swapChain.extent.height,
+				this->target.getExtent().width,
+				this->target.getExtent().height,
 				1
 		};
 
@@ -106,17 +225,30 @@ void renderpass::createPassAndFrameBuffers() {
 }
 
 void renderpass::begin(const vk::UniqueCommandBuffer& buffer, std::size_t index, const vk::Rect2D &renderArea, const std::vector<vk::ClearValue> &clearValues, vk::SubpassContents contents) {
+	auto allClearValues = clearValues;
+
+	if (allClearValues.empty()) {
+		allClearValues.emplace_back();
+	}
+
+	for (auto attachment = allClearValues.size(); attachment < this->renderPassAttachements.size(); ++attachment) {
+		allClearValues.emplace_back(this->transients[attachment - 1].clear);
+	}
+
 	vk::RenderPassBeginInfo rpbi {
 		this->renderPass.get(),
 		this->frameBuffers[index].get(),
 		renderArea,
-		static_cast<std::uint32_t>(clearValues.size()), clearValues.data()
+		static_cast<std::uint32_t>(allClearValues.size()), allClearValues.data()
 	};
 
 	buffer->beginRenderPass(rpbi, contents);
 }
 
-void renderpass::inherit(vk::CommandBufferInheritanceInfo& cbii, bool includeFramebuffer) {
+void renderpass::inherit(vk::CommandBufferInheritanceInfo& cbii, std::optional<std::size_t> frameBufferIndex, std::uint32_t subpass) const noexcept {
 	cbii.renderPass = this->renderPass.get();
-	cbii.subpass = 0;
+	cbii.subpass = subpass;
+
+	// Without a framebuffer the secondary buffer can be executed with any of them
+	cbii.framebuffer = frameBufferIndex ? this->frameBuffers[frameBufferIndex.value()].get() : vk::Framebuffer();
 }
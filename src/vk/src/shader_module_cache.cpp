@@ -0,0 +1,84 @@
+#include "shader_module_cache.h"
+
+#include <app_com.h>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <string_view>
+
+std::shared_ptr<const shader_module_cache::shader> shader_module_cache::get(const std::string& name) {
+	std::scoped_lock lock(this->mutex);
+
+	if (const auto it = this->byName.find(name); it != this->byName.end()) {
+		return it->second;
+	}
+
+	try {
+		return load(name);
+	} catch (const std::runtime_error& error) {
+		spdlog::get("graphics")->error("Can't load shader {}: {}", name, error.what());
+		exit(EXIT_FAILURE);
+	}
+}
+
+std::shared_ptr<const shader_module_cache::shader> shader_module_cache::reload(const std::string& name) {
+	std::scoped_lock lock(this->mutex);
+
+	std::shared_ptr<const shader> loaded;
+
+	// A broken recompile mustn't take the running app down, the pipelines keep what they use
+	try {
+		loaded = load(name);
+	} catch (const std::runtime_error& error) {
+		spdlog::get("graphics")->error("Shader {} not reloaded, keeping the current module: {}", name, error.what());
+		return this->byName.at(name);
+	}
+
+	// Code no name maps to anymore is only kept alive here, pipelines still using an old version keep it until the next reload
+	for (auto it = this->byHash.begin(); it != this->byHash.end();) {
+		it = it->second.use_count() == 1 ? this->byHash.erase(it) : std::next(it);
+	}
+
+	return loaded;
+}
+
+std::size_t shader_module_cache::size() const {
+	std::scoped_lock lock(this->mutex);
+
+	return this->byHash.size();
+}
+
+std::shared_ptr<const shader_module_cache::shader> shader_module_cache::load(const std::string& name) {
+	const auto bytes = app_com::loadShader(name);
+
+	if (bytes.size() % sizeof(std::uint32_t) != 0) {
+		throw std::runtime_error("Shader " + name + " is not made of 32 bit words!");
+	}
+
+	const auto hash = std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+
+	std::vector<std::uint32_t> code(bytes.size() / sizeof(std::uint32_t));
+	std::memcpy(code.data(), bytes.data(), bytes.size());
+
+	// Colliding hashes of different code still get their own module, only the first one is shared
+	if (const auto it = this->byHash.find(hash); it != this->byHash.end() && it->second->code == code) {
+		this->byName[name] = it->second;
+		return it->second;
+	}
+
+	// Reflection first, a module the parser rejects never reaches the driver
+	spirv_reflection reflection(code);
+
+	const vk::ShaderModuleCreateInfo smci {
+		{},
+		code.size() * sizeof(std::uint32_t), code.data()
+	};
+
+	auto module = this->device.createShaderModuleUnique(smci);
+
+	auto loaded = std::make_shared<const shader>(shader{ std::move(code), std::move(module), std::move(reflection) });
+
+	this->byHash.try_emplace(hash, loaded);
+	this->byName[name] = loaded;
+
+	return loaded;
+}
@@ -0,0 +1,155 @@
+#include "shader_reloader.h"
+
+#include <ishotreload.h>
+#include <spdlog/spdlog.h>
+#include <utility>
+
+#ifdef DISPLAY_HOT_RELOAD
+#include <array>
+#include <fstream>
+#include <set>
+#include <unordered_map>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <shaderc/shaderc.hpp>
+#endif
+
+shader_reloader::shader_reloader(std::filesystem::path sourceDir, std::filesystem::path outputDir) : sourceDir(std::move(sourceDir)), outputDir(std::move(outputDir)) {
+	if constexpr (!com::isHotReload) {
+		spdlog::get("graphics")->warn("Shader hot reload requested but built without DISPLAY_HOT_RELOAD");
+		return;
+	}
+
+#ifdef DISPLAY_HOT_RELOAD
+	this->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	// Editors either rewrite the file or move a temporary over it
+	if (this->inotify < 0 || inotify_add_watch(this->inotify, this->sourceDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		spdlog::get("graphics")->error("Can not watch shader sources in {}!", this->sourceDir.string());
+		return;
+	}
+
+	this->running = true;
+	this->watcher = std::thread([this]() { watch(); });
+
+	spdlog::get("graphics")->info("Watching shader sources in {}", this->sourceDir.string());
+#endif
+}
+
+shader_reloader::~shader_reloader() {
+	this->running = false;
+
+	if (this->watcher.joinable()) {
+		this->watcher.join();
+	}
+
+#ifdef DISPLAY_HOT_RELOAD
+	if (this->inotify >= 0) {
+		close(this->inotify);
+	}
+#endif
+}
+
+std::vector<std::string> shader_reloader::poll() {
+	std::scoped_lock lock(this->mutex);
+	return std::exchange(this->compiled, {});
+}
+
+void shader_reloader::watch() {
+#ifdef DISPLAY_HOT_RELOAD
+	alignas(inotify_event) std::array<char, 4096> events{};
+
+	while (this->running) {
+		pollfd pfd { this->inotify, POLLIN, 0 };
+
+		// Times out regularly so that the destructor doesn't wait for the next edit
+		if (::poll(&pfd, 1, shader_reloader::POLL_TIMEOUT_MS) <= 0) {
+			continue;
+		}
+
+		// One save often raises several events, each file is compiled once per batch
+		std::set<std::filesystem::path> changed;
+
+		for (auto length = read(this->inotify, events.data(), events.size()); length > 0; length = read(this->inotify, events.data(), events.size())) {
+			for (auto offset = 0; offset < length;) {
+				const auto* event = reinterpret_cast<const inotify_event*>(events.data() + offset);
+
+				if (event->len > 0) {
+					changed.emplace(this->sourceDir / event->name);
+				}
+
+				offset += static_cast<decltype(offset)>(sizeof(inotify_event) + event->len);
+			}
+		}
+
+		for (const auto& source : changed) {
+			if (compile(source)) {
+				std::scoped_lock lock(this->mutex);
+				this->compiled.emplace_back(source.stem().string());
+			}
+		}
+	}
+#endif
+}
+
+bool shader_reloader::compile(const std::filesystem::path& source) {
+#ifdef DISPLAY_HOT_RELOAD
+	static const std::unordered_map<std::string, shaderc_shader_kind> kinds {
+		{ ".vert", shaderc_vertex_shader },
+		{ ".frag", shaderc_fragment_shader },
+		{ ".comp", shaderc_compute_shader },
+		{ ".geom", shaderc_geometry_shader },
+		{ ".tesc", shaderc_tess_control_shader },
+		{ ".tese", shaderc_tess_evaluation_shader }
+	};
+
+	// Swap files and other editor leftovers
+	const auto kind = kinds.find(source.extension().string());
+
+	if (kind == kinds.end()) {
+		return false;
+	}
+
+	std::ifstream input(source);
+	const std::string glsl(std::istreambuf_iterator<char>(input), {});
+
+	// Same settings as glslc -O in add_spirv_target
+	shaderc::CompileOptions options;
+	options.SetOptimizationLevel(shaderc_optimization_level_performance);
+	options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+
+	const shaderc::Compiler compiler;
+	const auto result = compiler.CompileGlslToSpv(glsl, kind->second, source.filename().string().c_str(), options);
+
+	if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+		// The previous SPIR-V stays in place, pipelines keep rendering with it
+		spdlog::get("graphics")->warn("Shader {} failed to compile:\n{}", source.filename().string(), result.GetErrorMessage());
+		return false;
+	}
+
+	// Written next to it and renamed, loadShader never sees a partial file
+	const auto output = this->outputDir / (source.stem().string() + ".spv");
+	auto temporary = output;
+	temporary += ".tmp";
+
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(result.cbegin()), static_cast<std::streamsize>(std::distance(result.cbegin(), result.cend()) * sizeof(std::uint32_t)));
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary, output, error);
+
+	if (error) {
+		spdlog::get("graphics")->warn("Can not replace {}: {}", output.string(), error.message());
+		return false;
+	}
+
+	spdlog::get("graphics")->info("Recompiled shader {}", source.filename().string());
+
+	return true;
+#else
+	return false;
+#endif
+}
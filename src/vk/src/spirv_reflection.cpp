@@ -0,0 +1,352 @@
+#include "spirv_reflection.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+	constexpr std::uint32_t SPIRV_MAGIC = 0x07230203;
+	constexpr std::size_t HEADER_WORDS = 5;
+
+	// Subset of the SPIR-V specification's enumerants the reflection looks at
+	enum class op : std::uint32_t {
+		entryPoint = 15,
+		typeBool = 20,
+		typeInt = 21,
+		typeFloat = 22,
+		typeVector = 23,
+		typeMatrix = 24,
+		typeImage = 25,
+		typeSampler = 26,
+		typeSampledImage = 27,
+		typeArray = 28,
+		typeRuntimeArray = 29,
+		typeStruct = 30,
+		typePointer = 32,
+		constant = 43,
+		variable = 59,
+		decorate = 71,
+		memberDecorate = 72
+	};
+
+	enum class decoration : std::uint32_t {
+		block = 2,
+		bufferBlock = 3,
+		arrayStride = 6,
+		matrixStride = 7,
+		builtIn = 11,
+		location = 30,
+		binding = 33,
+		descriptorSet = 34,
+		offset = 35
+	};
+
+	enum class storage_class : std::uint32_t {
+		uniformConstant = 0,
+		input = 1,
+		uniform = 2,
+		pushConstant = 9,
+		storageBuffer = 12
+	};
+
+	constexpr std::uint32_t DIM_BUFFER = 5;
+	constexpr std::uint32_t DIM_SUBPASS_DATA = 6;
+
+	vk::ShaderStageFlagBits executionStage(std::uint32_t model) {
+		switch (model) {
+			case 0: return vk::ShaderStageFlagBits::eVertex;
+			case 1: return vk::ShaderStageFlagBits::eTessellationControl;
+			case 2: return vk::ShaderStageFlagBits::eTessellationEvaluation;
+			case 3: return vk::ShaderStageFlagBits::eGeometry;
+			case 4: return vk::ShaderStageFlagBits::eFragment;
+			case 5: return vk::ShaderStageFlagBits::eCompute;
+			default: throw std::runtime_error("Unsupported SPIR-V execution model!");
+		}
+	}
+
+	// Result id to its defining instruction's operands past the result id, plus what is decorated on it
+	struct id_info {
+		op opcode{};
+		std::vector<std::uint32_t> operands{};
+		std::unordered_map<decoration, std::uint32_t> decorations{};
+		std::vector<std::unordered_map<decoration, std::uint32_t>> memberDecorations{};
+
+		[[nodiscard]] std::optional<std::uint32_t> decorated(decoration d) const {
+			const auto it = this->decorations.find(d);
+			return it != this->decorations.end() ? std::optional(it->second) : std::nullopt;
+		};
+
+		[[nodiscard]] std::optional<std::uint32_t> memberDecorated(std::size_t member, decoration d) const {
+			if (member >= this->memberDecorations.size()) {
+				return std::nullopt;
+			}
+
+			const auto it = this->memberDecorations[member].find(d);
+			return it != this->memberDecorations[member].end() ? std::optional(it->second) : std::nullopt;
+		};
+	};
+
+	class module_ids {
+	private:
+		std::unordered_map<std::uint32_t, id_info> ids{};
+
+	public:
+		id_info& operator[](std::uint32_t id) { return this->ids[id]; };
+
+		[[nodiscard]] const id_info& at(std::uint32_t id) const {
+			const auto it = this->ids.find(id);
+
+			if (it == this->ids.end()) {
+				throw std::runtime_error("Malformed SPIR-V, undefined id!");
+			}
+
+			return it->second;
+		};
+
+		[[nodiscard]] std::uint32_t constant(std::uint32_t id) const {
+			return at(id).operands.at(1);
+		};
+
+		// Byte size with explicit layout, strides and offsets come from decorations where the type has them
+		[[nodiscard]] std::uint32_t size(std::uint32_t type, std::optional<std::uint32_t> matrixStride = {}) const {
+			const auto& info = at(type);
+
+			switch (info.opcode) {
+				case op::typeBool:
+					return 4;
+				case op::typeInt:
+				case op::typeFloat:
+					return info.operands[0] / 8;
+				case op::typeVector:
+					return info.operands[1] * size(info.operands[0]);
+				case op::typeMatrix:
+					return info.operands[1] * matrixStride.value_or(size(info.operands[0]));
+				case op::typeArray:
+					return constant(info.operands[1]) * info.decorated(decoration::arrayStride).value_or(size(info.operands[0]));
+				case op::typeRuntimeArray:
+					return 0;
+				case op::typeStruct: {
+					std::uint32_t end = 0;
+
+					for (std::size_t member = 0; member < info.operands.size(); ++member) {
+						const auto offset = info.memberDecorated(member, decoration::offset).value_or(0);
+						end = std::max(end, offset + size(info.operands[member], info.memberDecorated(member, decoration::matrixStride)));
+					}
+
+					return end;
+				}
+				default:
+					throw std::runtime_error("Unsupported SPIR-V type in a block!");
+			}
+		};
+
+		// Strips arrays around a descriptor, multiplying their lengths, runtime arrays count as unsized
+		[[nodiscard]] std::pair<std::uint32_t, std::uint32_t> element(std::uint32_t type) const {
+			std::uint32_t count = 1;
+
+			for (auto info = &at(type);; info = &at(type)) {
+				if (info->opcode == op::typeArray) {
+					count *= constant(info->operands[1]);
+				} else if (info->opcode == op::typeRuntimeArray) {
+					count = 0;
+				} else {
+					return { type, count };
+				}
+
+				type = info->operands[0];
+			}
+		};
+
+		[[nodiscard]] std::optional<vk::DescriptorType> descriptorType(std::uint32_t type, storage_class storage) const {
+			const auto& info = at(type);
+
+			switch (storage) {
+				case storage_class::storageBuffer:
+					return vk::DescriptorType::eStorageBuffer;
+				case storage_class::uniform:
+					return info.decorated(decoration::bufferBlock) ? vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eUniformBuffer;
+				case storage_class::uniformConstant:
+					break;
+				default:
+					return std::nullopt;
+			}
+
+			switch (info.opcode) {
+				case op::typeSampledImage:
+					return vk::DescriptorType::eCombinedImageSampler;
+				case op::typeSampler:
+					return vk::DescriptorType::eSampler;
+				case op::typeImage: {
+					// Sampled type, dim, depth, arrayed, multisampled, sampled, format
+					const auto dim = info.operands[1];
+					const auto storageImage = info.operands[5] == 2;
+
+					if (dim == DIM_SUBPASS_DATA) {
+						return vk::DescriptorType::eInputAttachment;
+					}
+
+					if (dim == DIM_BUFFER) {
+						return storageImage ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+					}
+
+					return storageImage ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+				}
+				default:
+					return std::nullopt;
+			}
+		};
+
+		[[nodiscard]] vk::Format format(std::uint32_t type) const {
+			constexpr std::array<std::array<vk::Format, 4>, 3> formats {{
+				{ vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat, vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat },
+				{ vk::Format::eR32Sint, vk::Format::eR32G32Sint, vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint },
+				{ vk::Format::eR32Uint, vk::Format::eR32G32Uint, vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint }
+			}};
+
+			const auto& info = at(type);
+			const auto& scalar = info.opcode == op::typeVector ? at(info.operands[0]) : info;
+			const auto components = info.opcode == op::typeVector ? info.operands[1] : 1;
+
+			if ((scalar.opcode != op::typeFloat && scalar.opcode != op::typeInt) || scalar.operands[0] != 32 || components > 4) {
+				throw std::runtime_error("Unsupported vertex input type!");
+			}
+
+			const auto kind = scalar.opcode == op::typeFloat ? 0 : scalar.operands[1] == 1 ? 1 : 2;
+
+			return formats[kind][components - 1];
+		};
+	};
+}
+
+spirv_reflection::spirv_reflection(std::span<const std::uint32_t> code) {
+	if (code.size() < HEADER_WORDS || code[0] != SPIRV_MAGIC) {
+		throw std::runtime_error("Not a SPIR-V module!");
+	}
+
+	module_ids ids;
+	std::vector<std::uint32_t> variables;
+	bool entryPoint = false;
+
+	// Every instruction starts with its word count in the high and its opcode in the low half word
+	for (std::size_t word = HEADER_WORDS; word < code.size();) {
+		const auto count = code[word] >> 16;
+		const auto opcode = static_cast<op>(code[word] & 0xffff);
+
+		if (count == 0 || word + count > code.size()) {
+			throw std::runtime_error("Malformed SPIR-V, truncated instruction!");
+		}
+
+		const auto operands = code.subspan(word + 1, count - 1);
+
+		switch (opcode) {
+			case op::entryPoint:
+				// Modules compiled from GLSL have a single one
+				if (!entryPoint) {
+					this->stage = executionStage(operands[0]);
+					entryPoint = true;
+				}
+				break;
+			case op::decorate:
+				ids[operands[0]].decorations[static_cast<decoration>(operands[1])] = operands.size() > 2 ? operands[2] : 0;
+				break;
+			case op::memberDecorate: {
+				auto& members = ids[operands[0]].memberDecorations;
+				members.resize(std::max<std::size_t>(members.size(), operands[1] + 1));
+				members[operands[1]][static_cast<decoration>(operands[2])] = operands.size() > 3 ? operands[3] : 0;
+				break;
+			}
+			case op::typeBool:
+			case op::typeInt:
+			case op::typeFloat:
+			case op::typeVector:
+			case op::typeMatrix:
+			case op::typeImage:
+			case op::typeSampler:
+			case op::typeSampledImage:
+			case op::typeArray:
+			case op::typeRuntimeArray:
+			case op::typeStruct:
+			case op::typePointer: {
+				auto& info = ids[operands[0]];
+				info.opcode = opcode;
+				info.operands.assign(operands.begin() + 1, operands.end());
+				break;
+			}
+			case op::constant:
+			case op::variable: {
+				// Result type comes first here, the result id second
+				auto& info = ids[operands[1]];
+				info.opcode = opcode;
+				info.operands = { operands[0], operands.size() > 2 ? operands[2] : 0 };
+
+				if (opcode == op::variable) {
+					variables.emplace_back(operands[1]);
+				}
+				break;
+			}
+			default:
+				break;
+		}
+
+		word += count;
+	}
+
+	if (!entryPoint) {
+		throw std::runtime_error("SPIR-V module without entry point!");
+	}
+
+	for (const auto id : variables) {
+		const auto& variable = ids.at(id);
+		const auto storage = static_cast<storage_class>(variable.operands[1]);
+		// Pointer operands are its storage class and the pointee
+		const auto type = ids.at(variable.operands[0]).operands[1];
+
+		if (const auto set = variable.decorated(decoration::descriptorSet)) {
+			const auto [element, count] = ids.element(type);
+			const auto descriptorType = ids.descriptorType(element, storage);
+
+			if (!descriptorType) {
+				throw std::runtime_error("Unsupported SPIR-V descriptor type!");
+			}
+
+			this->bindings.emplace_back(descriptor_binding{ set.value(), variable.decorated(decoration::binding).value_or(0), descriptorType.value(), count });
+		} else if (storage == storage_class::pushConstant) {
+			const auto& block = ids.at(type);
+			std::uint32_t offset = std::numeric_limits<std::uint32_t>::max();
+
+			for (std::size_t member = 0; member < block.operands.size(); ++member) {
+				offset = std::min(offset, block.memberDecorated(member, decoration::offset).value_or(0));
+			}
+
+			// Ranges are in multiples of 4 bytes, a trailing smaller member still occupies a whole word
+			const auto size = (ids.size(type) - offset + 3) & ~3u;
+			this->pushConstants = vk::PushConstantRange{ this->stage, offset, size };
+		} else if (storage == storage_class::input && this->stage == vk::ShaderStageFlagBits::eVertex && !variable.decorated(decoration::builtIn)) {
+			const auto location = variable.decorated(decoration::location);
+
+			if (!location) {
+				continue;
+			}
+
+			// Matrices are passed as one attribute per column, arrays as one per element
+			auto [attribute, elements] = ids.element(type);
+			const auto& info = ids.at(attribute);
+			const auto columns = info.opcode == op::typeMatrix ? info.operands[1] : 1;
+			const auto column = info.opcode == op::typeMatrix ? info.operands[0] : attribute;
+
+			for (std::uint32_t i = 0; i < elements * columns; ++i) {
+				this->inputs.emplace_back(vertex_input{ location.value() + i, ids.format(column), ids.size(column) });
+			}
+		}
+	}
+
+	std::sort(this->bindings.begin(), this->bindings.end(), [](const auto& a, const auto& b) { return std::tie(a.set, a.binding) < std::tie(b.set, b.binding); });
+	std::sort(this->inputs.begin(), this->inputs.end(), [](const auto& a, const auto& b) { return a.location < b.location; });
+}
+
+bool spirv_reflection::sameInterface(const spirv_reflection& other) const noexcept {
+	return this->stage == other.stage && this->bindings == other.bindings && this->pushConstants == other.pushConstants && this->inputs == other.inputs;
+}
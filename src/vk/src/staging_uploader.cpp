@@ -0,0 +1,208 @@
+#include "staging_uploader.h"
+
+bool upload_ticket::ready() const {
+	return this->uploader == nullptr || this->uploader->isComplete(this->batch);
+}
+
+void upload_ticket::wait() const {
+	if (this->uploader) {
+		this->uploader->waitFor(this->batch);
+	}
+}
+
+staging_uploader::staging_uploader(const engine_vk& engine) : engine(engine) {
+	this->ring = this->engine.createBuffer(staging_uploader::RING_SIZE, vk::BufferUsageFlagBits::eTransferSrc, engine_vk::memory_usage::upload);
+}
+
+staging_uploader::ticket staging_uploader::upload(const engine_vk::vk_buffer& dst, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size) {
+	std::scoped_lock lock(this->mutex);
+
+	vk::DeviceSize done = 0;
+
+	// Anything larger than the ring is streamed through it in ring-sized chunks
+	while (done < size) {
+		const auto chunk = std::min(size - done, staging_uploader::RING_SIZE);
+		const auto offset = reserve(chunk);
+
+		this->engine.copy(this->ring, data, offset, done, chunk);
+
+		if (!this->recording) {
+			this->recording = std::move(this->engine.allocateCmdBuffers(vk::QueueFlagBits::eTransfer, vk::CommandBufferLevel::ePrimary, 1)[0]);
+
+			vk::CommandBufferBeginInfo cbbi {};
+			cbbi.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+			this->recording->begin(cbbi);
+		}
+
+		const vk::BufferCopy copyRegion { offset, dstOffset + done, chunk };
+		this->recording->copyBuffer(this->ring.buffer.get(), dst.buffer.get(), 1, &copyRegion);
+
+		done += chunk;
+	}
+
+	if (this->engine.separateQueues()) {
+		this->ownershipTransfers.emplace_back(
+			vk::AccessFlagBits::eTransferWrite,
+			vk::AccessFlags{},
+			this->engine.transferFamilyIndex,
+			this->engine.graphicsFamilyIndex,
+			dst.buffer.get(),
+			dstOffset,
+			size
+		);
+	}
+
+	return ticket(this, this->recordingBatch);
+}
+
+staging_uploader::ticket staging_uploader::flush() {
+	std::scoped_lock lock(this->mutex);
+
+	if (!this->recording) {
+		return ticket(this, this->recordingBatch - 1);
+	}
+
+	if (this->engine.separateQueues()) {
+		// Release half of the ownership transfer, recordAcquire records the matching acquire
+		this->recording->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, {},
+										 0, nullptr,
+										 static_cast<std::uint32_t>(this->ownershipTransfers.size()), this->ownershipTransfers.data(),
+										 0, nullptr);
+	} else if (this->engine.sharedQueue()) {
+		// Later submissions on the same queue are ordered after this barrier, no semaphore needed
+		const vk::MemoryBarrier mb { vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead };
+		this->recording->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, 1, &mb, 0, nullptr, 0, nullptr);
+	}
+
+	this->recording->end();
+
+	batch b { this->recordingBatch, std::move(this->recording), {}, vk::QueueFlagBits::eTransfer, 0, this->head };
+
+	const auto transferValue = this->engine.submit(vk::QueueFlagBits::eTransfer, { engine_vk::submission{ { b.cmdBuffer.get() } } });
+
+	if (this->engine.sharedQueue()) {
+		b.value = transferValue;
+	} else {
+		// The graphics queue acquires the batch, so every later graphics submission sees it without waiting on the CPU
+		b.acquireCmdBuffer = recordAcquire();
+
+		const engine_vk::submission acquire {
+			{ b.acquireCmdBuffer.get() },
+			{ engine_vk::timeline_wait{ vk::QueueFlagBits::eTransfer, transferValue, vk::PipelineStageFlagBits::eAllCommands } }
+		};
+
+		b.family = vk::QueueFlagBits::eGraphics;
+		b.value = this->engine.submit(vk::QueueFlagBits::eGraphics, { acquire });
+	}
+
+	this->ownershipTransfers.clear();
+	this->inFlight.push_back(std::move(b));
+
+	return ticket(this, this->recordingBatch++);
+}
+
+vk::UniqueCommandBuffer staging_uploader::recordAcquire() const {
+	auto buffer = std::move(this->engine.allocateCmdBuffers(vk::QueueFlagBits::eGraphics, vk::CommandBufferLevel::ePrimary, 1)[0]);
+
+	vk::CommandBufferBeginInfo cbbi {};
+	cbbi.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+	buffer->begin(cbbi);
+
+	if (this->engine.separateQueues()) {
+		auto acquires = this->ownershipTransfers;
+
+		for (auto& barrier : acquires) {
+			barrier.srcAccessMask = {};
+			barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+		}
+
+		buffer->pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands, {},
+								0, nullptr,
+								static_cast<std::uint32_t>(acquires.size()), acquires.data(),
+								0, nullptr);
+	} else {
+		// Second queue of the graphics family, only visibility is needed
+		const vk::MemoryBarrier mb { vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eMemoryRead };
+		buffer->pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eAllCommands, {}, 1, &mb, 0, nullptr, 0, nullptr);
+	}
+
+	buffer->end();
+
+	return buffer;
+}
+
+void staging_uploader::collect() {
+	std::scoped_lock lock(this->mutex);
+
+	while (!this->inFlight.empty() && this->engine.isComplete(this->inFlight.front().family, this->inFlight.front().value)) {
+		this->tail = this->inFlight.front().ringEnd;
+		this->completedBatch = this->inFlight.front().id;
+		this->inFlight.pop_front();
+	}
+}
+
+vk::DeviceSize staging_uploader::reserve(vk::DeviceSize size) {
+	for (;;) {
+		const auto position = this->head % staging_uploader::RING_SIZE;
+		auto aligned = (position + staging_uploader::RING_ALIGNMENT - 1) / staging_uploader::RING_ALIGNMENT * staging_uploader::RING_ALIGNMENT;
+
+		// Never split a copy across the end of the ring, skip to the start instead
+		if (aligned + size > staging_uploader::RING_SIZE) {
+			aligned = staging_uploader::RING_SIZE;
+		}
+
+		const auto skip = aligned - position;
+
+		if (this->head + skip + size - this->tail <= staging_uploader::RING_SIZE) {
+			this->head += skip;
+			const auto offset = this->head % staging_uploader::RING_SIZE;
+			this->head += size;
+			return offset;
+		}
+
+		if (this->recording) {
+			flush();
+		}
+
+		if (this->inFlight.empty()) {
+			this->head += skip;
+			this->tail = this->head;
+		} else {
+			retireOldest();
+		}
+	}
+}
+
+void staging_uploader::retireOldest() {
+	auto& oldest = this->inFlight.front();
+
+	this->engine.waitTimeline(oldest.family, oldest.value);
+
+	this->tail = oldest.ringEnd;
+	this->completedBatch = oldest.id;
+	this->inFlight.pop_front();
+}
+
+bool staging_uploader::isComplete(std::uint64_t batchId) {
+	std::scoped_lock lock(this->mutex);
+
+	if (batchId >= this->recordingBatch) {
+		return false;
+	}
+
+	collect();
+
+	return this->completedBatch >= batchId;
+}
+
+void staging_uploader::waitFor(std::uint64_t batchId) {
+	std::scoped_lock lock(this->mutex);
+
+	if (batchId >= this->recordingBatch) {
+		static_cast<void>(flush());
+	}
+
+	while (this->completedBatch < batchId) {
+		retireOldest();
+	}
+}
@@ -74,25 +74,13 @@ swapchain::swapchain(const engine_vk& engine) : engine(engine) {
 		imageCount = std::clamp(imageCount, capabilities.minImageCount, capabilities.maxImageCount);
 	}
 
-	auto sharingMode = vk::SharingMode::eExclusive;
-	std::uint32_t indexCount = 0;
-
-	this->queueFamilyIndices[0] = this->engine.graphicsFamilyIndex;
-	this->queueFamilyIndices[1] = this->engine.transferFamilyIndex;
-
-	const bool separateQueues = this->engine.separateQueues();
-
-	if (separateQueues) {
-		sharingMode = vk::SharingMode::eConcurrent;
-		indexCount = 2;
-	}
-
 	this->swci.minImageCount = imageCount;
 	this->swci.imageArrayLayers = 1;
 	this->swci.imageUsage = vk::ImageUsageFlagBits::eColorAttachment;
-	this->swci.imageSharingMode = sharingMode;
-	this->swci.queueFamilyIndexCount = indexCount;
-	this->swci.pQueueFamilyIndices = this->queueFamilyIndices.data();
+	// Only ever rendered to and presented from the graphics queue, uploads hand their resources over explicitly
+	this->swci.imageSharingMode = vk::SharingMode::eExclusive;
+	this->swci.queueFamilyIndexCount = 0;
+	this->swci.pQueueFamilyIndices = nullptr;
 	this->swci.preTransform = capabilities.currentTransform;
 	this->swci.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
 	this->swci.presentMode = this->presentMode;
@@ -135,10 +123,22 @@ void swapchain::createSwapChain() {
 
 	this->swci.surface = *surface;
 
-	this->swapChain.reset(); //Can have only one SwapchainKHR at a time
+	// Handing over the old swapchain lets the driver reuse its resources and keep presenting until the new one is ready
+	auto oldSwapChain = std::move(this->swapChain);
+	this->swci.oldSwapchain = oldSwapChain.get();
 
 	this->swapChain = this->engine.logicalDevice->createSwapchainKHRUnique(this->swci);
 
+	this->swci.oldSwapchain = nullptr;
+
+	// Frames still in flight render to the old views, both go once those submissions completed
+	if (oldSwapChain) {
+		this->engine.retire(std::move(this->swapChainImageViews));
+		this->engine.retire(std::move(oldSwapChain));
+	}
+
+	this->swapChainImageViews.clear();
+
 	this->swapChainImages = this->engine.logicalDevice->getSwapchainImagesKHR(this->swapChain.get());
 	this->swapChainImageViews.resize(this->swapChainImages.size());
 
@@ -166,11 +166,11 @@ void swapchain::createSwapChain() {
 	}
 }
 
-std::uint32_t swapchain::acquireNextImage(const vk::Semaphore& semaphore) const {
+std::uint32_t swapchain::acquireNextImage(const vk::Semaphore& semaphore) {
 	return this->engine.logicalDevice->acquireNextImageKHR(this->swapChain.get(), std::numeric_limits<uint64_t>::max(), semaphore, nullptr).value;
 }
 
-vk::Result swapchain::present(const std::vector<vk::Semaphore>& waitSemaphores, std::uint32_t index) const {
+vk::Result swapchain::present(const std::vector<vk::Semaphore>& waitSemaphores, std::uint32_t index) {
 	vk::PresentInfoKHR pi {
 		static_cast<std::uint32_t>(waitSemaphores.size()), waitSemaphores.data(),
 		1, &this->swapChain.get(),
@@ -0,0 +1,45 @@
+#include "transient_allocator.h"
+
+transient_allocator::transient_allocator(const engine_vk& engine, std::size_t frames, vk::DeviceSize frameSize, const vk::BufferUsageFlags& usage) : engine(engine) {
+	const auto& limits = this->engine.getCapabilities().limits();
+
+	this->defaultAlignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+
+	// Frame regions start on atom boundaries so flushing one never touches another
+	const auto atom = std::max(limits.nonCoherentAtomSize, this->defaultAlignment);
+	this->frameSize = (frameSize + atom - 1) / atom * atom;
+
+	// Host writes straight into VRAM where the device allows it
+	this->buffer = this->engine.createBuffer(this->frameSize * frames, usage, engine_vk::memory_usage::rebar);
+}
+
+void transient_allocator::beginFrame(std::size_t frameSlot) noexcept {
+	this->frame = frameSlot;
+	this->head = 0;
+}
+
+std::optional<transient_allocator::allocation> transient_allocator::allocate(vk::DeviceSize size, std::optional<vk::DeviceSize> alignment) noexcept {
+	const auto align = alignment.value_or(this->defaultAlignment);
+	const auto offset = (this->head + align - 1) / align * align;
+
+	if (offset + size > this->frameSize) {
+		return {};
+	}
+
+	this->head = offset + size;
+
+	const auto bufferOffset = this->frame * this->frameSize + offset;
+
+	return allocation {
+		this->buffer.buffer.get(),
+		bufferOffset,
+		size,
+		static_cast<std::uint8_t*>(this->buffer.data()) + bufferOffset
+	};
+}
+
+void transient_allocator::flush() const {
+	if (this->head > 0) {
+		this->buffer.flush(this->frame * this->frameSize, this->head);
+	}
+}
@@ -1,22 +1,26 @@
 #include "triangle_renderer.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <isdebug.h>
+#include <ishotreload.h>
+#include <isprofiling.h>
+#include <profiler.h>
 #include <spdlog/spdlog.h>
 
-triangle_pipeline::triangle_pipeline(const engine_vk &engine) : pipeline(engine) {
-    addShader(vk::ShaderStageFlagBits::eVertex, "passthrough");
+triangle_pipeline::triangle_pipeline(const engine_vk &engine, const std::string& vertexShader) : pipeline(engine) {
+    addShader(vk::ShaderStageFlagBits::eVertex, vertexShader);
     addShader(vk::ShaderStageFlagBits::eFragment, "red");
 
     this->piasci.topology = vk::PrimitiveTopology::eTriangleList;
     this->piasci.primitiveRestartEnable = VK_FALSE;
 
-    this->bindingDescription = { triangle_vertex::bindingDescriptions()[0] };
-    this->attributeDescription = {triangle_vertex::attributeDescriptions()[0] };
+    reflectVertexInput();
 
-    this->pvisci.vertexBindingDescriptionCount = static_cast<std::uint32_t>(this->bindingDescription.size());
-    this->pvisci.pVertexBindingDescriptions = this->bindingDescription.data();
-
-    this->pvisci.vertexAttributeDescriptionCount = static_cast<std::uint32_t>(this->attributeDescription.size());
-    this->pvisci.pVertexAttributeDescriptions = this->attributeDescription.data();
+    if (this->vertexBindings.empty() || this->vertexBindings[0].stride != sizeof(triangle_vertex)) {
+        spdlog::get("graphics")->error("Vertex shader {} doesn't match triangle_vertex!", vertexShader);
+        exit(EXIT_FAILURE);
+    }
 
     this->pvsci.viewportCount = 1;
     this->pvsci.pViewports = nullptr;
@@ -33,24 +37,88 @@ triangle_pipeline::triangle_pipeline(const engine_vk &engine) : pipeline(engine)
     this->gpci.pDynamicState = &this->pdsci;
 }
 
-triangle_renderer::triangle_renderer(const engine_vk& engine) : engine(engine), trianglePipeline(engine), swapChain(engine), renderPass(engine, swapChain), nextImage(0), currentFrame(0) {
-    this->trianglePipeline.finalize(this->renderPass, this->swapChain);
+instanced_pipeline::instanced_pipeline(const engine_vk &engine) : triangle_pipeline(engine, engine.getBindless() ? "bindless_instanced" : "instanced") {
+    if (engine.getBindless()) {
+        useBindless(*engine.getBindless());
+    }
+
+    reflectLayout();
+
+    if (!engine.getBindless()) {
+        createDescriptorSetPool(1);
+    }
+}
+
+cull_pipeline::cull_pipeline(const engine_vk &engine) : compute_pipeline(engine, "cull") {
+    // Instances, commands and draw count, the push constant block is mirrored by constants
+    reflectLayout();
+
+    if (this->pushConstantRanges.size() != 1 || this->pushConstantRanges[0].offset != 0 || this->pushConstantRanges[0].size != sizeof(constants)) {
+        spdlog::get("graphics")->error("Push constants of cull.comp don't match cull_pipeline::constants!");
+        exit(EXIT_FAILURE);
+    }
+
+    createDescriptorSetPool(1);
 
-    this->imageAvailableSemaphores.reserve(swapchain::FRAMES_IN_FLIGHT);
-    this->renderFinishedSemaphores.reserve(swapchain::FRAMES_IN_FLIGHT);
-    this->inFlightFences.reserve(swapchain::FRAMES_IN_FLIGHT);
-    this->imagesInFlight.resize(this->swapChain.getNumImages(), {});
+    this->updateTemplate = createUpdateTemplate({
+        vk::DescriptorUpdateTemplateEntry{ 0, 0, 1, vk::DescriptorType::eStorageBuffer, offsetof(buffers, instances), sizeof(vk::DescriptorBufferInfo) },
+        vk::DescriptorUpdateTemplateEntry{ 1, 0, 1, vk::DescriptorType::eStorageBuffer, offsetof(buffers, commands), sizeof(vk::DescriptorBufferInfo) },
+        vk::DescriptorUpdateTemplateEntry{ 2, 0, 1, vk::DescriptorType::eStorageBuffer, offsetof(buffers, count), sizeof(vk::DescriptorBufferInfo) }
+    });
 
-    for(std::size_t i = 0; i < swapchain::FRAMES_IN_FLIGHT; ++i) {
+    // Nothing depends on the render pass, so the pipeline is built right away
+    finalize();
+}
+
+void cull_pipeline::write(const vk::DescriptorSet& set, const buffers& bound) const noexcept {
+    this->engine.updateDescriptorSet(set, this->updateTemplate.get(), &bound);
+}
+
+triangle_renderer::triangle_renderer(const engine_vk& engine, std::unique_ptr<render_target> target, job_system* jobs, std::size_t drawCount) : engine(engine), drawCount(drawCount), trianglePipeline(engine), instancedPipeline(engine), cullPipeline(engine),
+    target(std::move(target)), renderPass(engine, *this->target), dynamicPass(engine, *this->target),
+    primaryCmdBuffers(engine, vk::CommandBufferLevel::ePrimary, this->target->getNumImages()),
+    sceneCmdBuffers(engine, vk::CommandBufferLevel::eSecondary, triangle_renderer::scene_chunks),
+    nextImage(0), currentFrame(0) {
+    finalizePipelines();
+    if (!this->engine.getBindless()) {
+        this->instanceSet = this->instancedPipeline.getSets(1)[0];
+    }
+    this->cullSet = this->cullPipeline.getSets(1)[0];
+
+    this->imageAvailableSemaphores.reserve(render_target::FRAMES_IN_FLIGHT);
+    this->renderFinishedSemaphores.reserve(render_target::FRAMES_IN_FLIGHT);
+    this->frameValues.resize(render_target::FRAMES_IN_FLIGHT, 0);
+    this->visibleCommands.resize(render_target::FRAMES_IN_FLIGHT);
+    this->visibleCounts.resize(render_target::FRAMES_IN_FLIGHT, 0);
+    this->imageValues.resize(this->target->getNumImages(), 0);
+
+    for(std::size_t i = 0; i < render_target::FRAMES_IN_FLIGHT; ++i) {
         this->imageAvailableSemaphores.emplace_back(this->engine.createSemaphore());
         this->renderFinishedSemaphores.emplace_back(this->engine.createSemaphore());
-        this->inFlightFences.emplace_back(this->engine.createFence(vk::FenceCreateFlagBits::eSignaled));
     }
 
-    allocateCmdBuffers();
+    if (jobs) {
+        this->recorder = std::make_unique<parallel_recorder>(this->engine, *jobs, render_target::FRAMES_IN_FLIGHT);
+    }
+
+    if constexpr (com::isProfiling) {
+        this->gpuProfiler = std::make_unique<gpu_profiler>(this->engine, this->target->getNumImages());
+    }
+
+    if constexpr (com::isHotReload) {
+        this->shaderReloader = std::make_unique<shader_reloader>(com::shaderSourceDir);
+    }
+
     allocateVertexBuffer();
 }
 
+triangle_renderer::~triangle_renderer() {
+    // Only set with a bindless table, released once the frames still in flight completed
+    if (this->transformSlot) {
+        this->engine.getBindless()->remove(bindless_table::kind::buffer, this->transformSlot.value());
+    }
+}
+
 void triangle_renderer::allocateVertexBuffer() {
     const std::vector<triangle_pipeline::triangle_vertex> vertices = {
         triangle_pipeline::triangle_vertex(glm::vec3{0.0f, -0.5f, 0.0f}),
@@ -58,15 +126,19 @@ void triangle_renderer::allocateVertexBuffer() {
         triangle_pipeline::triangle_vertex(glm::vec3{-0.5f, 0.5f, 0.0f}),
     };
 
-    this->vertexBuffer = this->engine.createLocalBufferWithData(std::span(vertices).size_bytes(), vk::BufferUsageFlagBits::eVertexBuffer, vertices.data());
-}
+    auto vertex = this->engine.createLocalBufferWithData(std::span(vertices).size_bytes(), vk::BufferUsageFlagBits::eVertexBuffer, vertices.data());
+    auto index = this->engine.createLocalBufferWithData(std::span(triangle_renderer::indices).size_bytes(), vk::BufferUsageFlagBits::eIndexBuffer, triangle_renderer::indices.data());
+
+    this->vertexBuffer = std::move(vertex.first);
+    this->indexBuffer = std::move(index.first);
 
-void triangle_renderer::allocateCmdBuffers() {
-    this->cmdBuffers = this->engine.allocateCmdBuffers(vk::QueueFlagBits::eGraphics, vk::CommandBufferLevel::ePrimary, this->swapChain.getNumImages());
+    // Both tickets name the batch being recorded, submitting it is enough since it is acquired on the graphics queue
+    // ahead of the first frame's submit
+    static_cast<void>(this->engine.getUploader().flush());
 }
 
-void triangle_renderer::recordCmdBuffer(std::uint32_t index) noexcept {
-    const auto extent = this->swapChain.getExtent();
+void triangle_renderer::recordDraws(const vk::CommandBuffer& buffer, std::size_t begin, std::size_t end) const {
+    const auto extent = this->target->getExtent();
 
     vk::Viewport viewPort {
         0.0f,
@@ -81,82 +153,529 @@ void triangle_renderer::recordCmdBuffer(std::uint32_t index) noexcept {
         vk::Rect2D{vk::Offset2D{0, 0}, extent}
     };
 
-    const auto& buffer = this->cmdBuffers[index];
+    buffer.setViewport(0, 1, &viewPort);
+    buffer.setScissor(0, 1, &scissor);
+
+    if (this->indirect) {
+        recordIndirect(buffer);
+        return;
+    }
+
+    this->trianglePipeline.bind(buffer, vk::PipelineBindPoint::eGraphics);
+
+    const vk::Buffer vertexBuffers[] = { this->vertexBuffer.buffer.get() };
+    const vk::DeviceSize offsets[] = {0};
+
+    buffer.bindVertexBuffers(0, 1, vertexBuffers, offsets);
+
+    for (std::size_t i = begin; i < end; ++i) {
+        buffer.draw(triangle_renderer::vertex_count, 1, 0, 0);
+    }
+}
+
+void triangle_renderer::recordIndirect(const vk::CommandBuffer& buffer) const {
+    this->instancedPipeline.bind(buffer, vk::PipelineBindPoint::eGraphics);
+
+    if (const auto* bindless = this->engine.getBindless()) {
+        // The global set stays valid across setInstances, only the pushed index changes
+        this->instancedPipeline.bindDescriptorSets(buffer, vk::PipelineBindPoint::eGraphics, 0, 1, &bindless->set());
+        this->instancedPipeline.pushConstants(buffer, vk::ShaderStageFlagBits::eVertex, 0, sizeof(bindless_table::index), &this->transformSlot.value());
+    } else {
+        this->instancedPipeline.bindDescriptorSets(buffer, vk::PipelineBindPoint::eGraphics, 0, 1, &this->instanceSet);
+    }
+
+    const vk::DeviceSize offset = 0;
+
+    buffer.bindVertexBuffers(0, 1, &this->vertexBuffer.buffer.get(), &offset);
+    buffer.bindIndexBuffer(this->indexBuffer.buffer.get(), 0, vk::IndexType::eUint16);
 
-    buffer->reset({});
+    const auto& caps = this->engine.getCapabilities();
+    constexpr auto stride = static_cast<std::uint32_t>(sizeof(vk::DrawIndexedIndirectCommand));
 
+    // The CPU knows how many it wrote, only GPU written lists need their count read on the GPU
+    const auto cpuWritten = this->cpuCulling;
+    const auto commands = cpuWritten ? this->visibleCommands[this->currentFrame].buffer.get() : this->indirectBuffer.buffer.get();
+    const auto commandCount = cpuWritten ? this->visibleCounts[this->currentFrame] : this->indirectCommands;
+
+    if (caps.features12.drawIndirectCount && !cpuWritten) {
+        buffer.drawIndexedIndirectCount(commands, 0, this->countBuffer.buffer.get(), 0, commandCount, stride);
+    } else if (caps.features.multiDrawIndirect) {
+        buffer.drawIndexedIndirect(commands, 0, commandCount, stride);
+    } else {
+        for (std::uint32_t i = 0; i < commandCount; ++i) {
+            buffer.drawIndexedIndirect(commands, i * stride, 1, stride);
+        }
+    }
+}
+
+bool triangle_renderer::setVisibleInstances(std::vector<std::uint32_t> visible) {
+    // Like GPU culling, each written command selects its transform through firstInstance
+    if (!this->engine.getCapabilities().features.drawIndirectFirstInstance) {
+        return false;
+    }
+
+    this->visibleInstances = std::move(visible);
+    this->cpuCulling = true;
+    this->culling = false;
+
+    return true;
+}
+
+void triangle_renderer::writeVisibleCommands(std::size_t frame) {
+    auto& commands = this->visibleCommands[frame];
+    const auto bytes = std::max<std::size_t>(this->visibleInstances.size(), 1) * sizeof(vk::DrawIndexedIndirectCommand);
+
+    // Grown only, a previous frame's primary may still reference the old buffer
+    if (!commands.buffer || commands.memory.getSize() < bytes) {
+        if (commands.buffer) {
+            this->engine.retire(std::move(commands));
+        }
+
+        commands = this->engine.createBuffer(bytes, vk::BufferUsageFlagBits::eIndirectBuffer, engine_vk::memory_usage::upload);
+    }
+
+    auto* out = static_cast<vk::DrawIndexedIndirectCommand*>(commands.data());
+
+    for (const auto instance : this->visibleInstances) {
+        *out++ = vk::DrawIndexedIndirectCommand{ static_cast<std::uint32_t>(triangle_renderer::vertex_count), 1, 0, 0, instance };
+    }
+
+    commands.flush();
+
+    this->visibleCounts[frame] = static_cast<std::uint32_t>(this->visibleInstances.size());
+}
+
+void triangle_renderer::recordCulling(const vk::CommandBuffer& buffer) const {
+    // The previous frame's draws may still read the commands and count that culling rewrites
+    const vk::MemoryBarrier reuse { vk::AccessFlagBits::eIndirectCommandRead, vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite };
+    buffer.pipelineBarrier(vk::PipelineStageFlagBits::eDrawIndirect, vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, {}, 1, &reuse, 0, nullptr, 0, nullptr);
+
+    buffer.fillBuffer(this->countBuffer.buffer.get(), 0, sizeof(std::uint32_t), 0);
+
+    const vk::MemoryBarrier cleared { vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+    buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, 1, &cleared, 0, nullptr, 0, nullptr);
+
+    this->cullPipeline.bind(buffer, vk::PipelineBindPoint::eCompute);
+    this->cullPipeline.bindDescriptorSets(buffer, vk::PipelineBindPoint::eCompute, 0, 1, &this->cullSet);
+    this->cullPipeline.pushConstants(buffer, vk::ShaderStageFlagBits::eCompute, 0, sizeof(this->cullConstants), &this->cullConstants);
+    this->cullPipeline.dispatch(buffer, (this->instanceCount + cull_pipeline::GROUP_SIZE - 1) / cull_pipeline::GROUP_SIZE);
+
+    const vk::MemoryBarrier culled { vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead };
+    buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect, {}, 1, &culled, 0, nullptr, 0, nullptr);
+}
+
+bool triangle_renderer::setInstances(const std::vector<glm::mat4>& transforms, bool cull) {
+    // Culled commands select their transform through firstInstance, which is zero without the feature
+    const auto supported = !cull || this->engine.getCapabilities().features.drawIndirectFirstInstance;
+
+    if (!supported) {
+        spdlog::get("graphics")->warn("GPU culling needs drawIndirectFirstInstance, drawing every instance instead");
+        cull = false;
+    }
+
+    // The instance set is rewritten in place, no pending frame may still read it
+    waitAllFrames();
+
+    auto& uploader = this->engine.getUploader();
+
+    this->instanceCount = static_cast<std::uint32_t>(transforms.size());
+    this->indirect = true;
+    this->culling = cull;
+    this->cpuCulling = false;
+
+    const auto transformBytes = std::span(transforms).size_bytes();
+
+    this->ssboBuffer = this->engine.createBuffer(std::max<vk::DeviceSize>(transformBytes, sizeof(glm::mat4)), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst, engine_vk::memory_usage::device_local);
+
+    if (transformBytes > 0) {
+        static_cast<void>(uploader.upload(this->ssboBuffer, 0, transforms.data(), transformBytes));
+    }
+
+    const auto usage = vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
+
+    if (cull) {
+        // Worst case every instance is visible and gets a command of its own
+        this->indirectCommands = std::max(this->instanceCount, 1u);
+
+        this->indirectBuffer = this->engine.createBuffer(this->indirectCommands * sizeof(vk::DrawIndexedIndirectCommand), usage, engine_vk::memory_usage::device_local);
+        this->countBuffer = this->engine.createBuffer(sizeof(std::uint32_t), usage, engine_vk::memory_usage::device_local);
+
+        // Transforms map straight to clip space (instanced.vert has no camera), so the frustum is the clip volume
+        this->cullConstants.planes = culling::frustum::fromViewProjection(glm::mat4(1.0f)).planes;
+        this->cullConstants.bounds = glm::vec4(0.0f, 0.0f, 0.0f, triangle_renderer::bounding_radius);
+        this->cullConstants.instanceCount = this->instanceCount;
+        this->cullConstants.indexCount = static_cast<std::uint32_t>(triangle_renderer::vertex_count);
+        this->cullConstants.compact = this->engine.getCapabilities().features12.drawIndirectCount ? 1 : 0;
+
+        this->cullPipeline.write(this->cullSet, cull_pipeline::buffers {
+            { this->ssboBuffer.buffer.get(), 0, VK_WHOLE_SIZE },
+            { this->indirectBuffer.buffer.get(), 0, VK_WHOLE_SIZE },
+            { this->countBuffer.buffer.get(), 0, VK_WHOLE_SIZE }
+        });
+    } else {
+        // A single mesh, so one command draws every instance
+        const std::vector<vk::DrawIndexedIndirectCommand> commands {
+            { static_cast<std::uint32_t>(triangle_renderer::vertex_count), this->instanceCount, 0, 0, 0 }
+        };
+
+        this->indirectCommands = static_cast<std::uint32_t>(commands.size());
+
+        this->indirectBuffer = this->engine.createBuffer(std::span(commands).size_bytes(), usage, engine_vk::memory_usage::device_local);
+        this->countBuffer = this->engine.createBuffer(sizeof(std::uint32_t), usage, engine_vk::memory_usage::device_local);
+
+        static_cast<void>(uploader.upload(this->indirectBuffer, 0, commands.data(), std::span(commands).size_bytes()));
+        static_cast<void>(uploader.upload(this->countBuffer, 0, &this->indirectCommands, sizeof(std::uint32_t)));
+    }
+
+    // Acquired on the graphics queue ahead of the next frame's submit
+    static_cast<void>(uploader.flush());
+
+    if (auto* bindless = this->engine.getBindless()) {
+        if (this->transformSlot) {
+            bindless->remove(bindless_table::kind::buffer, this->transformSlot.value());
+        }
+
+        this->transformSlot = bindless->addBuffer(this->ssboBuffer.buffer.get());
+        this->primaryCmdBuffers.invalidate();
+        return supported;
+    }
+
+    const vk::DescriptorBufferInfo dbi { this->ssboBuffer.buffer.get(), 0, VK_WHOLE_SIZE };
+
+    const vk::WriteDescriptorSet wds {
+        this->instanceSet,
+        0,
+        0,
+        1,
+        vk::DescriptorType::eStorageBuffer,
+        nullptr,
+        &dbi
+    };
+
+    this->engine.updateDescriptorSets(wds);
+
+    this->primaryCmdBuffers.invalidate();
+
+    return supported;
+}
+
+void triangle_renderer::finalizePipelines() {
+    if (this->dynamicRendering) {
+        this->trianglePipeline.finalize(this->dynamicPass.getColorFormats());
+        this->instancedPipeline.finalize(this->dynamicPass.getColorFormats());
+    } else {
+        this->trianglePipeline.finalize(this->renderPass, *this->target);
+        this->instancedPipeline.finalize(this->renderPass, *this->target);
+    }
+}
+
+bool triangle_renderer::setDynamicRendering(bool enable) {
+    if (enable && !this->engine.getCapabilities().supportsDynamicRendering()) {
+        return false;
+    }
+
+    if (enable == this->dynamicRendering) {
+        return true;
+    }
+
+    // Recorded primaries and secondaries begin or inherit the previous kind of pass
+    waitAllFrames();
+
+    this->dynamicRendering = enable;
+
+    if (enable) {
+        static_cast<void>(this->dynamicPass.updateFormat());
+    } else {
+        // Framebuffers weren't kept up to date while rendering dynamically
+        static_cast<void>(this->renderPass.updateFormat());
+        this->renderPass.createPassAndFrameBuffers();
+    }
+
+    finalizePipelines();
+
+    this->primaryCmdBuffers.invalidate();
+    this->sceneCmdBuffers.invalidate();
+
+    return true;
+}
+
+void triangle_renderer::recordSceneChunk(std::size_t chunk, const vk::UniqueCommandBuffer& buffer) {
+    vk::CommandBufferInheritanceInfo cbii {};
+
+    if (this->dynamicRendering) {
+        this->dynamicPass.inherit(cbii);
+    } else {
+        this->renderPass.inherit(cbii);
+    }
+
+    // Simultaneous use: every target image's primary executes the same chunk, possibly while another is pending
+    const vk::CommandBufferBeginInfo cbbi {
+        vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eSimultaneousUse,
+        &cbii
+    };
+    buffer->begin(cbbi);
+
+    recordDraws(buffer.get(),
+                this->drawCount * chunk / triangle_renderer::scene_chunks,
+                this->drawCount * (chunk + 1) / triangle_renderer::scene_chunks);
+
+    buffer->end();
+}
+
+void triangle_renderer::recordPrimary(std::uint32_t image, const vk::UniqueCommandBuffer& buffer) {
     const vk::CommandBufferBeginInfo cbbi {};
     buffer->begin(cbbi);
 
+    std::uint32_t passScope = 0;
+
+    if constexpr (com::isProfiling) {
+        this->gpuProfiler->reset(buffer.get(), image);
+    }
+
+    // Dispatches aren't allowed inside a render pass
+    if (this->culling) {
+        std::uint32_t cullScope = 0;
+
+        if constexpr (com::isProfiling) {
+            cullScope = this->gpuProfiler->begin(buffer.get(), image, "culling");
+        }
+
+        recordCulling(buffer.get());
+
+        if constexpr (com::isProfiling) {
+            this->gpuProfiler->end(buffer.get(), image, cullScope);
+        }
+    }
+
+    if constexpr (com::isProfiling) {
+        passScope = this->gpuProfiler->begin(buffer.get(), image, "render pass");
+    }
+
     const std::array<float, 4> col{0.0f, 0.0f, 0.0f, 1.0f};
     const std::vector<vk::ClearValue> clearValues{ vk::ClearColorValue(col) };
-    const vk::Rect2D renderArea {{0,0}, this->swapChain.getExtent()};
+    const vk::Rect2D renderArea {{0,0}, this->target->getExtent()};
+
+    const auto begin = [this, &buffer, image, &renderArea, &clearValues](bool secondaries) {
+        if (this->dynamicRendering) {
+            this->dynamicPass.begin(buffer.get(), this->target->getImage(image), this->target->getImageView(image), renderArea, clearValues[0],
+                                    secondaries ? vk::RenderingFlagBitsKHR::eContentsSecondaryCommandBuffers : vk::RenderingFlagsKHR{});
+        } else {
+            this->renderPass.begin(buffer, image, renderArea, clearValues, secondaries ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline);
+        }
+    };
 
-    this->renderPass.begin(buffer, index, renderArea, clearValues, vk::SubpassContents::eInline);
+    // An indirect scene is a handful of commands, recorded inline instead of through workers or shared secondaries
+    if (this->indirect) {
+        begin(false);
+        recordDraws(buffer.get(), 0, this->instanceCount);
+    } else {
+        begin(true);
+
+        std::vector<vk::CommandBuffer> chunks;
+
+        if (this->recorder) {
+            vk::CommandBufferInheritanceInfo cbii {};
+
+            if (this->dynamicRendering) {
+                this->dynamicPass.inherit(cbii);
+            } else {
+                this->renderPass.inherit(cbii, image);
+            }
+
+            chunks = this->recorder->record(this->currentFrame, cbii, this->drawCount,
+                                            [this](const vk::CommandBuffer& b, std::size_t begin, std::size_t end) { recordDraws(b, begin, end); });
+        } else {
+            chunks.reserve(this->sceneCmdBuffers.size());
+
+            for (std::size_t i = 0; i < this->sceneCmdBuffers.size(); ++i) {
+                const auto& chunk = this->sceneCmdBuffers.get(i, [this, i](const vk::UniqueCommandBuffer& b) { recordSceneChunk(i, b); });
+                chunks.emplace_back(chunk.get());
+            }
+        }
 
-    buffer->setViewport(0, 1, &viewPort);
-    buffer->setScissor(0, 1, &scissor);
+        buffer->executeCommands(static_cast<std::uint32_t>(chunks.size()), chunks.data());
+    }
 
-    this->trianglePipeline.bind(buffer, vk::PipelineBindPoint::eGraphics);
+    if (this->dynamicRendering) {
+        this->dynamicPass.end(buffer.get(), this->target->getImage(image));
+    } else {
+        buffer->endRenderPass();
+    }
 
-    const vk::Buffer vertexBuffers[] = { this->vertexBuffer.buffer.get() };
-    const vk::DeviceSize offsets[] = {0};
+    if constexpr (com::isProfiling) {
+        this->gpuProfiler->end(buffer.get(), image, passScope);
+    }
+
+    buffer->end();
+}
 
-    buffer->bindVertexBuffers(0, 1, vertexBuffers, offsets);
+void triangle_renderer::waitAllFrames() noexcept {
+    // Values on one queue complete in order, waiting for the newest covers every slot
+    this->engine.waitTimeline(vk::QueueFlagBits::eGraphics, *std::max_element(this->frameValues.begin(), this->frameValues.end()));
+}
 
-    buffer->draw(triangle_renderer::vertex_count, 1, 0, 0);
+void triangle_renderer::reloadShaders() {
+    const std::array<pipeline*, 3> pipelines { &this->trianglePipeline, &this->instancedPipeline, &this->cullPipeline };
 
-    buffer->endRenderPass();
-    buffer->end();
+    for (const auto& shader : this->shaderReloader->poll()) {
+        for (auto* p : pipelines) {
+            if (p->usesShader(shader)) {
+                p->reloadShaders();
+            }
+        }
+    }
+
+    // Rebuilds run in the background, whatever is done gets swapped in between two frames
+    bool swapped = false;
+
+    for (auto* p : pipelines) {
+        swapped |= p->swapRebuilt();
+    }
+
+    // Secondaries are only re-recorded once no frame executing them is pending, drawFrame takes care of it
+    if (swapped) {
+        this->primaryCmdBuffers.invalidate();
+        this->sceneCmdBuffers.invalidate();
+    }
 }
 
 void triangle_renderer::startFrame() noexcept {
+    if constexpr (com::isHotReload) {
+        try {
+            reloadShaders();
+        } catch (const std::exception& e) {
+            spdlog::get("graphics")->warn("Shader reload failed: {}", e.what());
+        }
+    }
 }
 
 void triangle_renderer::drawFrame() noexcept {
+    const auto frameStart = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration waited{};
+
+    const auto waitFor = [this, &waited](std::uint64_t value) {
+        profile_scope scope("fence wait");
+        const auto waitStart = std::chrono::steady_clock::now();
+        this->engine.waitTimeline(vk::QueueFlagBits::eGraphics, value);
+        waited += std::chrono::steady_clock::now() - waitStart;
+    };
+
     try {
-        this->nextImage = this->swapChain.acquireNextImage(this->imageAvailableSemaphores[this->currentFrame].get());
+        const auto frame = this->currentFrame;
 
-        if (this->imagesInFlight[this->nextImage]) {
-            this->engine.waitFence(this->imagesInFlight[this->nextImage]);
+        static_cast<void>(this->engine.collectRetired());
+        this->engine.getUploader().collect();
+
+        // Only block until the GPU is done with this frame slot's resources, the other slots keep executing
+        waitFor(this->frameValues[frame]);
+
+        {
+            profile_scope scope("acquire");
+            this->nextImage = this->target->acquireNextImage(this->imageAvailableSemaphores[frame].get());
         }
 
-        this->imagesInFlight[this->nextImage] = this->inFlightFences[currentFrame].get();
+        if (this->imageValues[this->nextImage] != 0) {
+            waitFor(this->imageValues[this->nextImage]);
 
-        std::vector waitSemaphores { this->imageAvailableSemaphores[this->currentFrame].get() };
-        std::vector signalSemaphores { this->renderFinishedSemaphores[this->currentFrame].get() };
+            // Its previous submission is complete, so are the timestamps it wrote
+            if constexpr (com::isProfiling) {
+                this->gpuProfiler->collect(this->nextImage);
+            }
+        }
+
+        std::vector waitSemaphores { this->imageAvailableSemaphores[frame].get() };
+        std::vector signalSemaphores { this->renderFinishedSemaphores[frame].get() };
         std::vector<vk::PipelineStageFlags> waitStages { vk::PipelineStageFlagBits::eColorAttachmentOutput };
 
-        vk::SubmitInfo si {
-            static_cast<std::uint32_t>(waitSemaphores.size()), waitSemaphores.data(),
-            waitStages.data(),
-            1, &this->cmdBuffers[this->nextImage].get(),
-            static_cast<std::uint32_t>(signalSemaphores.size()), signalSemaphores.data()
-        };
+        const auto image = this->nextImage;
+        vk::CommandBuffer cmdBuffer;
+
+        {
+            profile_scope scope("record");
+
+            // The primary draws from this frame slot's command list, so it is re-recorded along with it
+            if (this->indirect) {
+                if (this->cpuCulling) {
+                    writeVisibleCommands(frame);
+                    this->primaryCmdBuffers.invalidate(image);
+                }
+            } else if (this->recorder) {
+                this->recorder->beginFrame(frame);
+                this->primaryCmdBuffers.invalidate(image);
+            } else if (this->sceneCmdBuffers.anyDirty()) {
+                // Re-recording a secondary in place invalidates every primary executing it, so nothing referencing them
+                // may be pending, fresh secondaries as after a resize are recorded right away
+                if (this->sceneCmdBuffers.anyDirtyRecorded()) {
+                    waitAllFrames();
+                }
+
+                this->primaryCmdBuffers.invalidate();
+            }
+
+            cmdBuffer = this->primaryCmdBuffers.get(image, [this, image](const vk::UniqueCommandBuffer& b) { recordPrimary(image, b); }).get();
+        }
 
-        this->engine.resetFence(*this->inFlightFences[this->currentFrame]);
+        const engine_vk::submission submission { { cmdBuffer }, {}, waitSemaphores, waitStages, signalSemaphores };
 
-        this->recordCmdBuffer(this->nextImage);
+        {
+            profile_scope scope("submit");
+            const auto value = this->engine.submit(vk::QueueFlagBits::eGraphics, { submission });
+            this->frameValues[frame] = value;
+            this->imageValues[image] = value;
+        }
 
-        this->engine.submit(vk::QueueFlagBits::eGraphics, si, *this->inFlightFences[this->currentFrame]);
+        {
+            profile_scope scope("present");
+            this->target->present(signalSemaphores, this->nextImage);
+        }
 
-        this->swapChain.present(signalSemaphores, this->nextImage);
+        this->currentFrame = (frame + 1) % render_target::FRAMES_IN_FLIGHT;
 
-        this->currentFrame = (this->currentFrame + 1) % swapchain::FRAMES_IN_FLIGHT;
+    } catch (const vk::OutOfDateKHRError &) {
+        // Everything replaced below is retired to the engine, frames in flight finish with the old resources
+        this->target->recreate();
+
+        // Viewport and scissor are dynamic, the pipeline only depends on render pass compatibility
+        if (this->dynamicRendering) {
+            // Views are passed at begin, only a new format affects the pipelines
+            if (this->dynamicPass.updateFormat()) {
+                finalizePipelines();
+            }
+        } else {
+            if (this->renderPass.updateFormat()) {
+                this->renderPass.createPass();
+                finalizePipelines();
+            }
+
+            this->renderPass.createFrameBuffers();
+        }
 
-        this->engine.waitDeviceIdle();
+        this->imageValues.assign(this->target->getNumImages(), 0);
 
-    } catch (const vk::OutOfDateKHRError &) {
-        this->engine.waitDeviceIdle();
+        this->primaryCmdBuffers.resize(this->target->getNumImages());
+        // New viewport and scissor, pending secondaries are retired instead of waited for
+        this->sceneCmdBuffers.resize(this->sceneCmdBuffers.size());
 
-        this->swapChain.createSwapChain();
+        if constexpr (com::isProfiling) {
+            this->gpuProfiler->resize(this->target->getNumImages());
+        }
+    }
 
-        this->renderPass.updateFormat();
-        this->renderPass.createPassAndFrameBuffers();
+    const auto frameEnd = std::chrono::steady_clock::now();
+    this->timing.add(frameEnd - frameStart, waited);
 
-        this->trianglePipeline.finalize(this->renderPass, this->swapChain);
+    if constexpr (com::isProfiling) {
+        auto& p = profiler::get();
+        p.record(profiler::track::cpu, "frame", p.toMicroseconds(frameStart), std::chrono::duration<double, std::micro>(frameEnd - frameStart).count());
+        p.nextFrame();
+    }
 
-        allocateCmdBuffers();
+    if constexpr (com::isDebug) {
+        if (this->timing.frames == frame_timing::REPORT_INTERVAL) {
+            spdlog::get("graphics")->debug("Frame {:.3f} ms, fence wait {:.3f} ms, unblocked {:.1f}%",
+                                           this->timing.averageFrameMs(), this->timing.averageWaitMs(), this->timing.unblockedShare() * 100.0);
+            this->timing = {};
+        }
     }
 }
 